@@ -0,0 +1,224 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "StateArena.h"
+
+//==============================================================================
+// Antiderivative anti-aliasing (ADAA) for Processor2's tanh and hard clip shapers.
+//
+// Instead of sampling f(x[n]), each output averages f over the line between successive
+// inputs, which is a difference of antiderivatives and suppresses the aliases folding
+// back from above Nyquist, so lower oversampling factors reach the same alias rejection:
+//
+//   1st order  y[n] = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1])         half a sample late
+//   2nd order  y[n] = 2 (D(x[n], x[n-1]) - D(x[n-1], x[n-2])) / (x[n] - x[n-2]),
+//              D(a, b) = (F2(a) - F2(b)) / (a - b)                       one sample late
+//
+// F1 and F2 are the first and second antiderivatives. Where the differences get too small
+// to divide by, the limits are used instead (Bilbao, Esqueda, Parker, Valimaki: "Antiderivative
+// Antialiasing for Memoryless Nonlinearities", 2017). Everything is computed in double, as
+// the second order divides by differences twice; it runs sample by sample, and the
+// antiderivatives of the previous input are kept rather than computed again.
+namespace Adaa
+{
+enum class Function
+{
+    tanh,
+    hardClip
+};
+
+constexpr auto maximumOrder = 2;
+
+// How late the output is, in samples at the rate the shaper runs at.
+inline double getDelay(int order)
+{
+    return 0.5 * order;
+}
+
+namespace detail
+{
+//==============================================================================
+// Li2(-u) for u in (0, 1], from the Bernoulli series in w = -log(1 + u), |w| <= log 2,
+// which is within 1e-16 after these terms.
+inline double dilogarithmOfNegative(double u)
+{
+    const auto w = -std::log1p(u);
+    const auto w2 = w * w;
+
+    auto p = 7.0 / 7846046208000.0;
+    p = p * w2 - 691.0 / 16999766784000.0;
+    p = p * w2 + 1.0 / 526901760.0;
+    p = p * w2 - 1.0 / 10886400.0;
+    p = p * w2 + 1.0 / 211680.0;
+    p = p * w2 - 1.0 / 3600.0;
+    p = p * w2 + 1.0 / 36.0;
+
+    return w - 0.25 * w2 + w * w2 * p;
+}
+
+constexpr auto ln2 = 0.693147180559945309417;
+
+struct Tanh
+{
+    static double f(double x)
+    {
+        return std::tanh(x);
+    }
+
+    // log(cosh(x)), written so it doesn't overflow
+    static double F1(double x)
+    {
+        const auto a = std::abs(x);
+        return a + std::log1p(std::exp(-2.0 * a)) - ln2;
+    }
+
+    // odd, x^2/2 - x log 2 + Li2(-e^-2x)/2 + pi^2/24 for x >= 0
+    static double F2(double x)
+    {
+        const auto a = std::abs(x);
+        const auto pi2 = MathConstants<double>::pi * MathConstants<double>::pi;
+        const auto magnitude = a * (0.5 * a - ln2)
+                             + 0.5 * dilogarithmOfNegative(std::exp(-2.0 * a)) + pi2 / 24.0;
+
+        return std::copysign(magnitude, x);
+    }
+};
+
+struct HardClip
+{
+    static double f(double x)
+    {
+        return jlimit(-1.0, 1.0, x);
+    }
+
+    static double F1(double x)
+    {
+        const auto a = std::abs(x);
+        return a <= 1.0 ? 0.5 * x * x : a - 0.5;
+    }
+
+    static double F2(double x)
+    {
+        const auto a = std::abs(x);
+        return a <= 1.0 ? x * x * x / 6.0 : std::copysign(0.5 * a * (a - 1.0) + 1.0 / 6.0, x);
+    }
+};
+
+// below this the divisions lose too many digits and the limits are closer
+constexpr auto tolerance = 1.0e-3;
+} // namespace detail
+
+//==============================================================================
+// The ADAA shaper with the history of each channel, for one stream of blocks. Feeding
+// two streams at different rates, as during an oversampling crossfade, needs two.
+template <typename SampleType>
+class Shaper
+{
+  public:
+    // Message thread, followed by allocate().
+    void prepare(int numChannels)
+    {
+        numStates = (size_t)numChannels;
+    }
+
+    void allocate(StateArena& arena)
+    {
+        states = arena.allocate<State>(numStates);
+    }
+
+    void reset()
+    {
+        if (states != nullptr)
+            std::fill(states, states + numStates, State{});
+    }
+
+    // y = trim * f(x) with `order` (1 or 2) ADAA, in place on every channel of the block.
+    void process(const dsp::AudioBlock<SampleType>& block, Function function, int order, SampleType trim)
+    {
+        if (function == Function::tanh)
+            process<detail::Tanh>(block, order, trim);
+        else
+            process<detail::HardClip>(block, order, trim);
+    }
+
+  private:
+    struct State
+    {
+        double x1 = 0, x2 = 0; // the previous two inputs
+        double antiderivative1 = 0; // F1(x1) or F2(x1), for the order in use
+        double difference1 = 0; // D(x1, x2), second order only
+    };
+
+    template <typename Curve>
+    void process(const dsp::AudioBlock<SampleType>& block, int order, SampleType trim)
+    {
+        const auto numChannels = jmin(block.getNumChannels(), numStates);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = block.getChannelPointer(channel);
+            auto& state = states[channel];
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                const auto y = order == 1 ? processFirstOrder<Curve>(state, (double)data[i])
+                                          : processSecondOrder<Curve>(state, (double)data[i]);
+                data[i] = (SampleType)y * trim;
+            }
+        }
+    }
+
+    template <typename Curve>
+    static double processFirstOrder(State& state, double x0)
+    {
+        const auto F1x0 = Curve::F1(x0);
+        const auto dx = x0 - state.x1;
+
+        const auto y = std::abs(dx) < detail::tolerance ? Curve::f(0.5 * (x0 + state.x1))
+                                                        : (F1x0 - state.antiderivative1) / dx;
+
+        state.x1 = x0;
+        state.antiderivative1 = F1x0;
+        return y;
+    }
+
+    template <typename Curve>
+    static double processSecondOrder(State& state, double x0)
+    {
+        const auto x1 = state.x1, x2 = state.x2;
+        const auto F2x0 = Curve::F2(x0);
+
+        const auto dx01 = x0 - x1;
+        const auto difference0 = std::abs(dx01) < detail::tolerance ? Curve::F1(0.5 * (x0 + x1))
+                                                                    : (F2x0 - state.antiderivative1) / dx01;
+
+        const auto dx02 = x0 - x2;
+        double y;
+
+        if (std::abs(dx02) >= detail::tolerance)
+        {
+            y = 2.0 * (difference0 - state.difference1) / dx02;
+        }
+        else
+        {
+            // x0 and x2 coincide: the derivative of D(a, x1) at their mean
+            const auto mean = 0.5 * (x0 + x2);
+            const auto delta = mean - x1;
+
+            y = std::abs(delta) < detail::tolerance
+                  ? Curve::f(0.5 * (mean + x1))
+                  : 2.0 / delta * (Curve::F1(mean) + (state.antiderivative1 - Curve::F2(mean)) / delta);
+        }
+
+        state.x2 = x1;
+        state.x1 = x0;
+        state.antiderivative1 = F2x0;
+        state.difference1 = difference0;
+        return y;
+    }
+
+    State* states = nullptr; // in the arena
+    size_t numStates = 0;
+};
+} // namespace Adaa
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "StateArena.h"
+
+//==============================================================================
+// Gathers the host's blocks into fixed-size blocks, for offline renders where the host
+// block size is small and latency doesn't matter.
+//
+// One buffer of blockSize samples per channel does both jobs: each incoming sample is
+// swapped with the processed sample at the same position, and whenever the buffer is
+// full of input it gets processed in place. So the output lags the input by exactly
+// blockSize samples, whatever the host block sizes.
+template <typename SampleType>
+class BlockAccumulator
+{
+  public:
+    // Message thread, followed by allocate(). A block size of 0 turns it off.
+    void prepare(int newNumChannels, int newBlockSize)
+    {
+        numChannels = newNumChannels;
+        blockSize = jmax(0, newBlockSize);
+    }
+
+    void allocate(StateArena& arena)
+    {
+        arena.allocate(buffer, numChannels, blockSize);
+    }
+
+    void reset()
+    {
+        buffer.clear();
+        position = 0;
+    }
+
+    bool isActive() const
+    {
+        return blockSize > 0;
+    }
+
+    int getLatency() const
+    {
+        return blockSize;
+    }
+
+    // Swaps the block's input for output processed earlier, calling `processBlock` with
+    // every full block of input on the way.
+    template <typename Func>
+    void process(const dsp::AudioBlock<SampleType>& block, Func&& processBlock)
+    {
+        const auto numSamples = (int)block.getNumSamples();
+        const auto numBlockChannels = jmin((int)block.getNumChannels(), buffer.getNumChannels());
+
+        for (auto start = 0; start < numSamples;)
+        {
+            const auto length = jmin(numSamples - start, blockSize - position);
+
+            for (auto channel = 0; channel < numBlockChannels; ++channel)
+            {
+                auto* samples = block.getChannelPointer((size_t)channel) + start;
+                std::swap_ranges(samples, samples + length, buffer.getWritePointer(channel, position));
+            }
+
+            start += length;
+            position += length;
+
+            if (position == blockSize)
+            {
+                auto full = dsp::AudioBlock<SampleType>(buffer);
+                processBlock(full);
+                position = 0;
+            }
+        }
+    }
+
+  private:
+    AudioBuffer<SampleType> buffer; // in the arena
+    int numChannels = 0;
+    int blockSize = 0;
+    int position = 0; // where the next input sample goes
+};
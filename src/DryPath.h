@@ -0,0 +1,203 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "StateArena.h"
+
+//==============================================================================
+// The dry signal for both mix stages, delayed once by the Processor2 latency.
+//
+// The outer mix wants the plugin input delayed, Processor2's own mix wants it after the
+// input gain. Rather than keeping a delay line for each, the per-sample input gain rides
+// along as one extra channel, so both taps come out of a single delay line:
+//   outer dry = x[n - L]
+//   inner dry = gain[n - L] * x[n - L]
+//
+// The delay line is a ring buffer in the state arena, with the first order Thiran allpass
+// of dsp::DelayLine for fractional latencies. While Processor2 crossfades between two
+// oversamplers, a second tap at the outgoing latency fades out along with it.
+template <typename SampleType>
+class DryPath
+{
+  public:
+    // Message thread, followed by allocate(). maximumDelay covers every latency setDelay() may
+    // be given later.
+    void prepare(const dsp::ProcessSpec& spec, int maximumDelay)
+    {
+        numChannels = (int)spec.numChannels;
+        maximumBlockSize = (int)spec.maximumBlockSize;
+
+        // the allpass reads one sample past the delay
+        ringSize = jmax(1, maximumDelay) + 2;
+
+        current.setDelay(0, ringSize);
+        previous.setDelay(0, ringSize);
+        fading = false;
+    }
+
+    void allocate(StateArena& arena)
+    {
+        arena.allocate(ring, numChannels + 1, ringSize);
+        arena.allocate(delayed, numChannels + 1, maximumBlockSize);
+        current.states = arena.allocate<SampleType>((size_t)numChannels + 1);
+        previous.states = arena.allocate<SampleType>((size_t)numChannels + 1);
+    }
+
+    void reset()
+    {
+        ring.clear();
+
+        for (auto* tap : {&current, &previous})
+            if (tap->states != nullptr)
+                std::fill(tap->states, tap->states + numChannels + 1, (SampleType)0);
+
+        writePosition = 0;
+        fading = false;
+    }
+
+    SampleType getDelay() const
+    {
+        return current.delay;
+    }
+
+    void setDelay(SampleType newDelay)
+    {
+        current.setDelay(newDelay, ringSize);
+    }
+
+    // The delay of the tap fading out during the next process() call that is given a fade.
+    // The first call of a fade hands it the current tap's allpass states, as those belong
+    // to the outgoing delay until setDelay() moved it.
+    void setPreviousDelay(SampleType previousDelay)
+    {
+        if (!fading)
+            std::copy(current.states, current.states + numChannels + 1, previous.states);
+
+        previous.setDelay(previousDelay, ringSize);
+        fading = true;
+    }
+
+    // Pushes the input block and its per-sample gain, and returns both delayed: channels
+    // [0, numChannels) hold the dry audio, channel numChannels the gain. With a `fade`, one
+    // value per sample going from 0 to 1, the result moves from the previous tap to the
+    // current one; without, the previous tap is dropped.
+    dsp::AudioBlock<const SampleType> process(
+        const dsp::AudioBlock<const SampleType>& input, const SampleType* gains, const SampleType* fade = nullptr
+    )
+    {
+        const auto numSamples = (int)input.getNumSamples();
+        fading = fading && fade != nullptr;
+
+        const auto push = [&](int channel, const SampleType* source)
+        {
+            auto* destination = delayed.getWritePointer(channel);
+            auto* samples = ring.getWritePointer(channel);
+            auto position = writePosition;
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                samples[position] = source[i];
+                destination[i] = current.read(samples, position, ringSize, current.states[channel]);
+
+                if (fading)
+                {
+                    const auto old = previous.read(samples, position, ringSize, previous.states[channel]);
+                    destination[i] = old + fade[i] * (destination[i] - old);
+                }
+
+                // written backwards, so the older samples follow
+                position = (position == 0 ? ringSize : position) - 1;
+            }
+        };
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+            push(channel, input.getChannelPointer((size_t)channel));
+
+        push(numChannels, gains);
+
+        writePosition = (writePosition + ringSize - numSamples % ringSize) % ringSize;
+
+        return dsp::AudioBlock<const SampleType>(delayed).getSubBlock(0, (size_t)numSamples);
+    }
+
+    // Pushes the input block without reading it back, for blocks that bypass both mixes, so
+    // the delay line still holds the recent input once they don't. `gain` fills the gain
+    // channel. Only the last samples that fit in the ring are written.
+    void write(const dsp::AudioBlock<const SampleType>& input, SampleType gain)
+    {
+        const auto numSamples = (int)input.getNumSamples();
+        const auto first = jmax(0, numSamples - ringSize);
+
+        const auto push = [&](int channel, auto&& getSample)
+        {
+            auto* samples = ring.getWritePointer(channel);
+            auto position = (writePosition + ringSize - first % ringSize) % ringSize;
+
+            for (auto i = first; i < numSamples; ++i)
+            {
+                samples[position] = getSample(i);
+                position = (position == 0 ? ringSize : position) - 1;
+            }
+        };
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = input.getChannelPointer((size_t)channel);
+            push(channel, [source](int i) { return source[i]; });
+        }
+
+        push(numChannels, [gain](int) { return gain; });
+
+        writePosition = (writePosition + ringSize - numSamples % ringSize) % ringSize;
+    }
+
+  private:
+    // One read position into the ring, with an allpass state per channel.
+    struct Tap
+    {
+        void setDelay(SampleType newDelay, int ringSize)
+        {
+            if (approximatelyEqual(newDelay, delay))
+                return;
+
+            delay = jlimit((SampleType)0, (SampleType)(ringSize - 2), newDelay);
+            integer = (int)std::floor(delay);
+            fraction = delay - (SampleType)integer;
+
+            // the allpass is poor for short fractional delays, so these borrow a whole sample
+            if (fraction < (SampleType)0.618 && integer >= 1)
+            {
+                fraction += 1;
+                integer -= 1;
+            }
+
+            alpha = (1 - fraction) / (1 + fraction);
+        }
+
+        SampleType read(const SampleType* samples, int position, int ringSize, SampleType& state) const
+        {
+            auto index1 = position + integer;
+            auto index2 = index1 + 1;
+
+            if (index2 >= ringSize)
+            {
+                index1 %= ringSize;
+                index2 %= ringSize;
+            }
+
+            const auto value1 = samples[index1];
+            state = fraction == 0 ? value1 : samples[index2] + alpha * (value1 - state);
+            return state;
+        }
+
+        SampleType delay = 0, fraction = 0, alpha = 1;
+        int integer = 0;
+        SampleType* states = nullptr; // in the arena
+    };
+
+    AudioBuffer<SampleType> ring, delayed; // in the arena
+    Tap current, previous;
+    bool fading = false;
+    int numChannels = 0, maximumBlockSize = 0, ringSize = 1;
+    int writePosition = 0;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "PolyphaseOversampler.h"
+#include "RealtimeCheck.h"
+
+//==============================================================================
+// The oversamplers Processor2 can switch between, built on demand.
+//
+// prepare() builds only the active one. Any other factor is requested from the audio
+// thread, built on a process-wide background thread and handed back through an atomic
+// slot state, so sessions with hundreds of instances only pay for factors actually used.
+//
+// Past the processor2Oversampling choices sit linear-phase versions of the same factors,
+// which offline renders may ask for, see getLinearPhaseIndex. The 1x choice has no filters
+// and is its own linear-phase version.
+//
+// The oversamplers share their filter designs with every other instance in the process, see
+// PolyphaseOversampler.h, so building one only allocates its states and buffers.
+template <typename SampleType>
+class OversamplerBank final : private TimeSliceClient
+{
+  public:
+    using Oversampler = Polyphase::Oversampler<SampleType>;
+    using FilterType = Polyphase::FilterType;
+
+    // indexed by the processor2Oversampling choice, then the linear-phase factors
+    struct Setting
+    {
+        size_t stages;
+        bool integerLatency;
+        FilterType filterType = FilterType::halfBandIIR;
+    };
+
+    static constexpr int numChoices = 7;
+
+    static constexpr std::array<Setting, 10> settings{
+        {
+         {1, false},
+         {2, false},
+         {3, false},
+
+         {1, true},
+         {2, true},
+         {3, true},
+
+         {0, false},
+
+         {1, true, FilterType::halfBandFIREquiripple},
+         {2, true, FilterType::halfBandFIREquiripple},
+         {3, true, FilterType::halfBandFIREquiripple},
+         }
+    };
+
+    static constexpr int size()
+    {
+        return (int)settings.size();
+    }
+
+    // The linear-phase setting with the factor of choice `index`. Its latency is much higher.
+    static constexpr int getLinearPhaseIndex(int index)
+    {
+        return numChoices + (int)settings[(size_t)index].stages - 1;
+    }
+
+    // Upper bound on getLatencyInSamples() over the processor2Oversampling choices, and with
+    // `linearPhase` over the linear-phase settings too, in samples at the base rate, so the
+    // same at every sample rate. Computed once per process; the linear-phase filters are only
+    // designed for it once an offline render asks for them.
+    static int getMaximumLatency(bool linearPhase)
+    {
+        static const auto choicesLatency = computeMaximumLatency(0, numChoices);
+
+        if (!linearPhase)
+            return choicesLatency;
+
+        static const auto allLatency = jmax(choicesLatency, computeMaximumLatency(numChoices, size()));
+        return allLatency;
+    }
+
+    ~OversamplerBank() override
+    {
+        preparationThread->removeTimeSliceClient(this);
+    }
+
+    // Message thread, with the audio thread stopped. Drops everything built for the old
+    // spec and builds `activeIndex` right away.
+    void prepare(const dsp::ProcessSpec& newSpec, int activeIndex)
+    {
+        preparationThread->removeTimeSliceClient(this);
+
+        spec = newSpec;
+
+        for (auto& slot : slots)
+        {
+            slot.oversampler.reset();
+            slot.state.store(empty);
+        }
+
+        build(activeIndex);
+
+        preparationThread->addTimeSliceClient(this);
+    }
+
+    void reset()
+    {
+        for (auto& slot : slots)
+            if (slot.state.load(std::memory_order_acquire) == ready)
+                slot.oversampler->reset();
+    }
+
+    // Audio thread, never blocks or allocates. Returns true once the oversampler is ready,
+    // until then the request is picked up by the background thread, which a new request wakes.
+    bool request(int index)
+    {
+        auto& slot = slots[(size_t)index];
+
+        if (auto expected = empty; slot.state.compare_exchange_strong(expected, requested))
+        {
+            // a short lock and a signal, once per factor change
+            MY_REALTIME_EXEMPTION;
+            preparationThread->moveToFrontOfQueue(this);
+        }
+
+        return slot.state.load(std::memory_order_acquire) == ready;
+    }
+
+    // Builds on the calling thread, for offline rendering where blocking is fine.
+    void build(int index)
+    {
+        auto& slot = slots[(size_t)index];
+
+        for (auto expected = slot.state.load(); expected != ready; expected = slot.state.load())
+        {
+            if (expected != building && slot.state.compare_exchange_strong(expected, building))
+            {
+                create(slot, (size_t)index);
+                return;
+            }
+
+            // the background thread is building it right now
+            std::this_thread::yield();
+        }
+    }
+
+    bool isReady(int index) const
+    {
+        return slots[(size_t)index].state.load(std::memory_order_acquire) == ready;
+    }
+
+    // Only valid for ready slots.
+    Oversampler& operator[](int index) const
+    {
+        jassert(isReady(index));
+        return *slots[(size_t)index].oversampler;
+    }
+
+  private:
+    enum State
+    {
+        empty,
+        requested,
+        building,
+        ready
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<Oversampler> oversampler;
+        std::atomic<State> state{empty};
+    };
+
+    // One low priority thread shared by every instance in the process.
+    struct PreparationThread final : public TimeSliceThread
+    {
+        PreparationThread()
+            : TimeSliceThread("Oversampler preparation")
+        {
+            startThread(Priority::low);
+        }
+
+        ~PreparationThread() override
+        {
+            stopThread(5000);
+        }
+    };
+
+    static int computeMaximumLatency(int begin, int end)
+    {
+        auto latency = 0;
+
+        for (auto index = begin; index < end; ++index)
+        {
+            const auto& setting = settings[(size_t)index];
+            const Oversampler oversampler(1, setting.stages, setting.filterType, setting.integerLatency);
+            latency = jmax(latency, (int)std::ceil(oversampler.getLatencyInSamples()) + 1);
+        }
+
+        return latency;
+    }
+
+    // Idle instances sleep until request() moves them to the front; the interval only bounds
+    // how long a request goes unnoticed if it came in while this very slice was running.
+    int useTimeSlice() override
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            auto expected = requested;
+
+            if (slots[i].state.compare_exchange_strong(expected, building))
+                create(slots[i], i);
+        }
+
+        return idleIntervalMs;
+    }
+
+    void create(Slot& slot, size_t index)
+    {
+        const auto& setting = settings[index];
+
+        slot.oversampler = std::make_unique<Oversampler>(
+            (size_t)spec.numChannels, setting.stages, setting.filterType, setting.integerLatency
+        );
+        slot.oversampler->initProcessing(spec.maximumBlockSize);
+
+        slot.state.store(ready, std::memory_order_release);
+    }
+
+    static constexpr int idleIntervalMs = 1000;
+
+    dsp::ProcessSpec spec{44100.0, 512, 2};
+    std::array<Slot, settings.size()> slots;
+    SharedResourcePointer<PreparationThread> preparationThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OversamplerBank)
+};
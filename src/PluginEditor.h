@@ -5,7 +5,9 @@
 #include "PluginProcessor.h"
 
 //==============================================================================
-class PluginEditor final : public AudioProcessorEditor
+class PluginEditor final
+    : public AudioProcessorEditor
+    , private Timer
 {
   public:
     explicit PluginEditor(PluginProcessor& p)
@@ -14,6 +16,9 @@ class PluginEditor final : public AudioProcessorEditor
     {
         comboEffect.addSectionHeading("Heading");
         comboEffect.addItem("Processor2", TabProcessor2);
+       #if MY_STAGE_PROFILING
+        comboEffect.addItem("Stage profile", TabStageProfile);
+       #endif
 
         comboEffect.setSelectedId(proc.indexTab + 1, dontSendNotification);
         comboEffect.onChange = [this]
@@ -27,20 +32,97 @@ class PluginEditor final : public AudioProcessorEditor
             comboEffect,
             labelEffect,
             basicControls,
-            Processor2Controls
+            Processor2Controls,
+            inputMeter,
+            outputMeter,
+            transferDisplay,
+            readout
         );
+       #if MY_STAGE_PROFILING
+        addChildComponent(stageProfileView);
+       #endif
+
         labelEffect.setJustificationType(Justification::centredRight);
         labelEffect.attachToComponent(&comboEffect, true);
 
+        readout.setJustificationType(Justification::centredLeft);
+
         updateVisibility();
 
-        setSize(800, 430);
+        // everything is covered by the background image, nothing behind needs painting
+        setOpaque(true);
+
+        setSize(800, 510);
         setResizable(false, false);
+
+        proc.setTelemetryEnabled(true);
+        startTimerHz(frameRate);
+    }
+
+    ~PluginEditor() override
+    {
+        proc.setTelemetryEnabled(false);
     }
 
     //==============================================================================
     void paint(Graphics& g) override
     {
+        const FrameStats::ScopedPaint scopedPaint(frameStats, g);
+
+        g.drawImage(background, getLocalBounds().toFloat());
+    }
+
+    const auto& getFrameStats() const
+    {
+        return frameStats;
+    }
+
+    void resized() override
+    {
+        auto rect = getLocalBounds();
+        rect.removeFromTop(topSize);
+        auto rectBottom = rect.removeFromBottom(bottomSize);
+
+        auto rectEffects = rect.removeFromBottom(tabSize);
+        auto rectChoice = rect.removeFromBottom(midSize);
+
+        comboEffect.setBounds(rectChoice.withSizeKeepingCentre(200, 24));
+        readout.setBounds(rectBottom.reduced(10, 0));
+
+        inputMeter.setBounds(rect.removeFromLeft(80).withSizeKeepingCentre(24, rect.getHeight() - 20));
+        outputMeter.setBounds(rect.removeFromRight(80).withSizeKeepingCentre(24, rect.getHeight() - 20));
+        transferDisplay.setBounds(rect.removeFromRight(rect.getHeight()).reduced(10));
+
+        rectEffects.reduce(20, 0);
+
+        basicControls.setBounds(rect);
+
+        forEach(
+            [&](Component& comp) { comp.setBounds(rectEffects); }, //
+            Processor2Controls
+        );
+
+       #if MY_STAGE_PROFILING
+        stageProfileView.setBounds(rectEffects);
+       #endif
+
+        background = renderBackground();
+    }
+
+  private:
+    //==============================================================================
+    // Everything static behind the controls, at the display's scale so it stays sharp.
+    Image renderBackground() const
+    {
+        const auto scale = getApproximateScaleFactorForComponent();
+        const auto width = jmax(1, roundToInt((float)getWidth() * scale));
+        const auto height = jmax(1, roundToInt((float)getHeight() * scale));
+
+        Image image(Image::RGB, width, height, false);
+
+        Graphics g(image);
+        g.addTransform(AffineTransform::scale(scale));
+
         auto rect = getLocalBounds();
 
         auto rectTop = rect.removeFromTop(topSize);
@@ -64,32 +146,311 @@ class PluginEditor final : public AudioProcessorEditor
         g.setFont(Font(20.0f).italicised().withExtraKerningFactor(0.1f));
         g.drawFittedText("DSP MODJOOL DEMO", rectTop.reduced(10, 0), Justification::centredLeft, 1);
 
-        g.setFont(Font(14.0f));
+        return image;
     }
 
-    void resized() override
+    //==============================================================================
+    // What painting this editor costs: every paint() of the editor and of its own displays,
+    // with the area it covered. The sliders are left to JUCE, which only repaints them when
+    // their values change. Only measured with MY_STAGE_PROFILING, whose tab shows them.
+    struct FrameStats
     {
-        auto rect = getLocalBounds();
-        rect.removeFromTop(topSize);
-        rect.removeFromBottom(bottomSize);
+        int64 frames = 0; // timer ticks
+        int64 paints = 0;
+        int64 paintedPixels = 0;
+        double paintMs = 0.0;
+        double maxPaintMs = 0.0;
 
-        auto rectEffects = rect.removeFromBottom(tabSize);
-        auto rectChoice = rect.removeFromBottom(midSize);
+        String toString() const
+        {
+            const auto perFrame = [this](double value) { return frames > 0 ? value / (double)frames : 0.0; };
 
-        comboEffect.setBounds(rectChoice.withSizeKeepingCentre(200, 24));
+            return String(frames) + " frames, " + String(perFrame((double)paints), 2) + " paints and "
+                 + String(perFrame((double)paintedPixels), 0) + " pixels per frame, "
+                 + String(perFrame(paintMs), 3) + " ms per frame, worst paint " + String(maxPaintMs, 3) + " ms";
+        }
 
-        rect.reduce(80, 0);
-        rectEffects.reduce(20, 0);
+        struct ScopedPaint
+        {
+           #if MY_STAGE_PROFILING
+            ScopedPaint(FrameStats& statsIn, const Graphics& g)
+                : stats(statsIn)
+                , area(g.getClipBounds())
+            {
+            }
 
-        basicControls.setBounds(rect);
+            ~ScopedPaint()
+            {
+                const auto ms = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
 
-        forEach(
-            [&](Component& comp) { comp.setBounds(rectEffects); }, //
-            Processor2Controls
+                stats.paints++;
+                stats.paintedPixels += (int64)area.getWidth() * area.getHeight();
+                stats.paintMs += ms;
+                stats.maxPaintMs = jmax(stats.maxPaintMs, ms);
+            }
+
+            FrameStats& stats;
+            const Rectangle<int> area;
+            const int64 start = Time::getHighResolutionTicks();
+           #else
+            ScopedPaint(FrameStats&, const Graphics&)
+            {
+            }
+           #endif
+        };
+    };
+
+    //==============================================================================
+    // Drains the telemetry FIFO once per frame and combines what arrived since the last one.
+    void timerCallback() override
+    {
+        Telemetry::Accumulator input, output;
+
+        proc.getTelemetry().popAll(
+            [&](const Telemetry::Frame& frame)
+            {
+                input.add(frame.input, frame.numSamples);
+                output.add(frame.output, frame.numSamples);
+            }
+        );
+
+        const auto inputLevels = input.getLevels();
+        const auto outputLevels = output.getLevels();
+
+        frameStats.frames++;
+
+        inputMeter.setLevels(inputLevels);
+        outputMeter.setLevels(outputLevels);
+        transferDisplay.update(inputMeter.getPeak());
+
+        clippedSamples += outputLevels.clippedSamples;
+
+        const auto toDecibels = [](float gain) { return Decibels::gainToDecibels(gain, -100.0f); };
+        const auto gainChange = inputLevels.rms > 0.0f && outputLevels.rms > 0.0f
+                                    ? String(toDecibels(outputLevels.rms) - toDecibels(inputLevels.rms), 1) + " dB"
+                                    : String("-");
+
+        readout.setText(
+            "Processor2 gain change " + gainChange + "    clipped samples " + String(clippedSamples),
+            dontSendNotification
         );
     }
 
-  private:
+    // Vertical meter for one tap point: RMS bar, falling peak line and a clip light that
+    // stays on for a second.
+    class LevelMeter final : public Component
+    {
+      public:
+        LevelMeter(const String& nameIn, FrameStats& statsIn)
+            : name(nameIn)
+            , stats(statsIn)
+        {
+            setOpaque(true);
+        }
+
+        // Only the rows that moved are repainted, usually a few pixels of the bar.
+        void setLevels(const Telemetry::Levels& levels)
+        {
+            // about 20 dB per second
+            constexpr auto fall = 0.92f;
+
+            rms = jmax(levels.rms, rms * fall);
+            peak = jmax(levels.peak, peak * fall);
+
+            const auto wasClipping = clipFrames > 0;
+            clipFrames = levels.clippedSamples > 0 ? frameRate : jmax(0, clipFrames - 1);
+
+            if (wasClipping != (clipFrames > 0))
+                repaint(clipArea);
+
+            const auto newRmsY = toY(rms), newPeakY = toY(peak);
+
+            if (newRmsY != rmsY || newPeakY != peakY)
+            {
+                const auto top = jmin(rmsY, newRmsY, peakY, newPeakY);
+                const auto bottom = jmax(rmsY, newRmsY, peakY, newPeakY) + peakHeight;
+
+                rmsY = newRmsY;
+                peakY = newPeakY;
+
+                repaint(barArea.getX(), top, barArea.getWidth(), bottom - top);
+            }
+        }
+
+        float getPeak() const
+        {
+            return peak;
+        }
+
+        void paint(Graphics& g) override
+        {
+            const FrameStats::ScopedPaint scopedPaint(stats, g);
+
+            g.fillAll(getLookAndFeel().findColour(ResizableWindow::backgroundColourId));
+
+            g.setColour(clipFrames > 0 ? Colours::red : Colours::darkgrey);
+            g.fillRect(clipArea);
+
+            g.setColour(Colours::black);
+            g.fillRect(barArea.withBottom(rmsY));
+
+            g.setColour(Colours::limegreen);
+            g.fillRect(barArea.withTop(rmsY));
+
+            g.setColour(Colours::white);
+            g.fillRect(barArea.withTop(peakY).withHeight(jmin(peakHeight, barArea.getBottom() - peakY)));
+
+            g.setFont(12.0f);
+            g.drawText(name, labelArea, Justification::centred);
+        }
+
+        void resized() override
+        {
+            barArea = getLocalBounds();
+            clipArea = barArea.removeFromTop(6);
+            labelArea = barArea.removeFromBottom(16);
+            barArea.removeFromTop(2);
+
+            rmsY = toY(rms);
+            peakY = toY(peak);
+        }
+
+      private:
+        // -60 dBFS at the bottom, +6 dBFS at the top
+        int toY(float gain) const
+        {
+            const auto proportion = jlimit(0.0f, 1.0f, (Decibels::gainToDecibels(gain, -60.0f) + 60.0f) / 66.0f);
+            return barArea.getBottom() - roundToInt(proportion * (float)barArea.getHeight());
+        }
+
+        static constexpr int peakHeight = 2;
+
+        String name;
+        FrameStats& stats;
+        Rectangle<int> clipArea, barArea, labelArea;
+        float rms = 0.0f, peak = 0.0f;
+        int rmsY = 0, peakY = 0;
+        int clipFrames = 0;
+    };
+
+    // Processor2's static curve from its gain, waveshaper and compensation over one full
+    // scale of input, with the current input peak marked. The curve is only rebuilt when
+    // one of those parameters changes; otherwise just the columns under the moving peak
+    // markers are repainted.
+    class TransferDisplay final : public Component
+    {
+      public:
+        TransferDisplay(const PluginProcessor::ParameterReferences::Processor2Group& stateIn, FrameStats& statsIn)
+            : state(stateIn)
+            , stats(statsIn)
+            , settings(getSettings())
+        {
+            setOpaque(true);
+        }
+
+        void update(float inputPeak)
+        {
+            if (const auto newSettings = getSettings(); newSettings != settings)
+            {
+                settings = newSettings;
+                rebuildCurve();
+                repaint();
+            }
+
+            const auto newMarkerOffset = roundToInt(jmin(inputPeak, 1.0f) * (float)getWidth() * 0.5f);
+
+            if (newMarkerOffset != markerOffset)
+            {
+                forEach(
+                    [this](int x) { repaint(x - 1, 0, 3, getHeight()); },
+                    getWidth() / 2 - markerOffset,
+                    getWidth() / 2 + markerOffset,
+                    getWidth() / 2 - newMarkerOffset,
+                    getWidth() / 2 + newMarkerOffset
+                );
+
+                markerOffset = newMarkerOffset;
+            }
+        }
+
+        void paint(Graphics& g) override
+        {
+            const FrameStats::ScopedPaint scopedPaint(stats, g);
+            const auto rect = getLocalBounds().toFloat();
+
+            g.fillAll(Colours::black);
+
+            g.setColour(Colours::darkgrey);
+            g.drawLine(rect.getX(), rect.getCentreY(), rect.getRight(), rect.getCentreY());
+            g.drawLine(rect.getCentreX(), rect.getY(), rect.getCentreX(), rect.getBottom());
+
+            g.setColour(Colours::orange.withAlpha(0.6f));
+
+            for (const auto x : {getWidth() / 2 - markerOffset, getWidth() / 2 + markerOffset})
+                g.drawLine((float)x, rect.getY(), (float)x, rect.getBottom());
+
+            g.setColour(std::get<3>(settings) ? Colours::white : Colours::grey);
+            g.strokePath(curve, PathStrokeType(1.5f));
+        }
+
+        void resized() override
+        {
+            rebuildCurve();
+        }
+
+      private:
+        using Settings = std::tuple<int, float, float, bool>;
+
+        Settings getSettings() const
+        {
+            return {state.type.getIndex(), state.inGain.get(), state.compGain.get(), state.enabled.get()};
+        }
+
+        void rebuildCurve()
+        {
+            const auto [typeIndex, inGainDb, compGainDb, enabled] = settings;
+            const auto rect = getLocalBounds().toFloat();
+
+            std::array<float, numPoints> values;
+            const auto inGain = Decibels::decibelsToGain(inGainDb);
+
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = inGain * jmap((float)i, 0.0f, (float)(numPoints - 1), -1.0f, 1.0f);
+
+            auto* channels = values.data();
+            PluginProcessor::applyWaveshaper(
+                dsp::AudioBlock<float>(&channels, 1, values.size()), typeIndex, *shaperTables
+            );
+
+            const auto compGain = Decibels::decibelsToGain(compGainDb);
+            curve.clear();
+
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                const auto x = jmap((float)i, 0.0f, (float)(numPoints - 1), rect.getX(), rect.getRight());
+                const auto output = jlimit(-1.0f, 1.0f, compGain * values[i]);
+                const auto y = jmap(output, -1.0f, 1.0f, rect.getBottom(), rect.getY());
+
+                if (i == 0)
+                    curve.startNewSubPath(x, y);
+                else
+                    curve.lineTo(x, y);
+            }
+        }
+
+        static constexpr int numPoints = 128;
+
+        const PluginProcessor::ParameterReferences::Processor2Group& state;
+        FrameStats& stats;
+
+        // shared with the float engines, built here first in double precision hosts
+        SharedResourcePointer<ShaperTables::Tables<float>> shaperTables;
+
+        Settings settings;
+        Path curve;
+        int markerOffset = 0;
+    };
+
     class ComponentWithParamMenu : public Component
     {
       public:
@@ -203,6 +564,114 @@ class PluginEditor final : public AudioProcessorEditor
         ComboBoxParameterAttachment attachment;
     };
 
+   #if MY_STAGE_PROFILING
+    //==============================================================================
+    // Where the audio path spends its cycles, per stage, and what painting the editor costs,
+    // refreshed once a second. Save writes the full histograms next to the user's documents.
+    class StageProfileView final
+        : public Component
+        , private Timer
+    {
+      public:
+        StageProfileView(StageProfiler::Histograms& histogramsIn, FrameStats& frameStatsIn)
+            : histograms(histogramsIn)
+            , frameStats(frameStatsIn)
+        {
+            resetButton.onClick = [this]
+            {
+                histograms.reset();
+                frameStats = {};
+                repaint();
+            };
+
+            saveButton.onClick = [this]
+            {
+                const auto file = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile(fileName);
+                saveButton.setButtonText(histograms.writeTo(file) ? "Saved" : "Failed");
+            };
+
+            addAllAndMakeVisible(*this, resetButton, saveButton);
+            startTimerHz(1);
+        }
+
+        void paint(Graphics& g) override
+        {
+            constexpr auto rowsPerColumn = ((int)StageProfiler::Stage::count + 1) / 2;
+
+            const auto summaries = histograms.getSummaries();
+            auto rect = getLocalBounds().withTrimmedRight(buttonWidth + 10);
+            const auto rowHeight = rect.getHeight() / (rowsPerColumn + 2);
+
+            g.setFont(13.0f);
+
+            g.setColour(Colours::lightgrey);
+            g.drawText(
+                "editor: " + frameStats.toString(),
+                rect.removeFromBottom(rowHeight).reduced(5, 0),
+                Justification::centredLeft
+            );
+
+            for (auto column = 0; column < 2; ++column)
+            {
+                auto rectColumn = rect.removeFromLeft(rect.getWidth() / (2 - column)).reduced(5, 0);
+                const auto drawRow = [&](Rectangle<int> row, const std::array<String, 4>& cells)
+                {
+                    g.drawText(cells[0], row.removeFromLeft(110), Justification::centredLeft);
+
+                    for (size_t i = 1; i < cells.size(); ++i)
+                    {
+                        const auto width = row.getWidth() / (int)(cells.size() - i);
+                        g.drawText(cells[i], row.removeFromLeft(width), Justification::centredRight);
+                    }
+                };
+
+                g.setColour(Colours::lightgrey);
+                drawRow(rectColumn.removeFromTop(rowHeight), {"stage", "mean", "p99", "share"});
+
+                g.setColour(Colours::white);
+
+                for (auto row = 0; row < rowsPerColumn; ++row)
+                {
+                    const auto index = (size_t)(column * rowsPerColumn + row);
+
+                    if (index >= summaries.size())
+                        break;
+
+                    const auto& summary = summaries[index];
+                    drawRow(
+                        rectColumn.removeFromTop(rowHeight),
+                        {StageProfiler::stageNames[index],
+                         String(summary.meanCycles, 0),
+                         String((int64)summary.p99Cycles),
+                         String(summary.share * 100.0, 1) + " %"}
+                    );
+                }
+            }
+        }
+
+        void resized() override
+        {
+            auto rect = getLocalBounds().removeFromRight(buttonWidth);
+
+            resetButton.setBounds(rect.removeFromTop(rect.getHeight() / 2).withSizeKeepingCentre(buttonWidth, 24));
+            saveButton.setBounds(rect.withSizeKeepingCentre(buttonWidth, 24));
+        }
+
+      private:
+        void timerCallback() override
+        {
+            repaint();
+        }
+
+        static constexpr auto buttonWidth = 90;
+        static constexpr auto fileName = "stage-profile.txt";
+
+        StageProfiler::Histograms& histograms;
+        FrameStats& frameStats;
+        TextButton resetButton{"Reset"}, saveButton{"Save"};
+    };
+   #endif
+
     //==============================================================================
     void updateVisibility()
     {
@@ -220,12 +689,17 @@ class PluginEditor final : public AudioProcessorEditor
             std::forward_as_tuple(Processor2Controls, TabProcessor2)
             //, std::forward_as_tuple(convolutionControls, TabConvolution),
         );
+
+       #if MY_STAGE_PROFILING
+        op(std::forward_as_tuple(stageProfileView, TabStageProfile));
+       #endif
     }
 
     enum EffectsTabs
     {
-        TabProcessor2 = 1
-        //,  TabConvolution,
+        TabProcessor2 = 1,
+        //  TabConvolution,
+        TabStageProfile // only offered with MY_STAGE_PROFILING
     };
 
     //==============================================================================
@@ -303,22 +777,33 @@ class PluginEditor final : public AudioProcessorEditor
             , gain(editor, state.inGain)
             , compv(editor, state.compGain)
             , type(editor, state.type)
+            , interpolation(editor, state.interpolation)
+            , antialiasing(editor, state.antialiasing)
+            , oversampler(editor, state.oversampler)
         {
-            addAllAndMakeVisible(*this, toggle, type, lowpass, highpass, mix, gain, compv);
+            addAllAndMakeVisible(
+                *this, toggle, type, interpolation, antialiasing, oversampler, lowpass, highpass, mix, gain, compv
+            );
         }
 
+        // The choices get a row of their own above the rotaries, which keep the full width
         void resized() override
         {
-            performLayout(getLocalBounds(), toggle, type, gain, highpass, lowpass, compv, mix);
+            auto rect = getLocalBounds();
+
+            performLayout(rect.removeFromTop(choiceRowSize), toggle, type, interpolation, antialiasing, oversampler);
+            performLayout(rect, gain, highpass, lowpass, compv, mix);
         }
 
         AttachedToggle toggle;
         AttachedSlider lowpass, highpass, mix, gain, compv;
-        AttachedCombo type;
+        AttachedCombo type, interpolation, antialiasing, oversampler;
     };
 
     //==============================================================================
-    static constexpr auto topSize = 40, bottomSize = 40, midSize = 40, tabSize = 155;
+    static constexpr auto topSize = 40, bottomSize = 40, midSize = 40;
+    static constexpr auto choiceRowSize = 80, tabSize = choiceRowSize + 155;
+    static constexpr auto frameRate = 30;
 
     //==============================================================================
     PluginProcessor& proc;
@@ -326,6 +811,18 @@ class PluginEditor final : public AudioProcessorEditor
     BasicControls basicControls{*this, proc.getParameterValues().mainGroup};
     Processor2Controls Processor2Controls{*this, proc.getParameterValues().processor2Group};
 
+    FrameStats frameStats;
+    Image background;
+
+    LevelMeter inputMeter{"IN", frameStats}, outputMeter{"OUT", frameStats};
+    TransferDisplay transferDisplay{proc.getParameterValues().processor2Group, frameStats};
+    Label readout;
+    int clippedSamples = 0;
+
+   #if MY_STAGE_PROFILING
+    StageProfileView stageProfileView{proc.getStageHistograms(), frameStats};
+   #endif
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginEditor)
 };
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include "PluginProcessor.h"
 
+#include "PluginEditor.h"
+
 AudioProcessorEditor* PluginProcessor::createEditor()
 {
-    return new GenericAudioProcessorEditor(*this);
-    // return new PluginEditor(*this);
+    return new PluginEditor(*this);
 }
 
 AudioProcessor* JUCE_CALLTYPE createPluginFilter()
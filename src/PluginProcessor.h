@@ -2,24 +2,52 @@
 
 #include <JuceHeader.h>
 
-namespace ID
-{
+#include "AdaaShaper.h"
+#include "BlockAccumulator.h"
+#include "DryPath.h"
+#include "OversamplerBank.h"
+#include "RealtimeCheck.h"
+#include "ShaperKernels.h"
+#include "ShaperTables.h"
+#include "StageProfiler.h"
+#include "StateArena.h"
+#include "StateFormat.h"
+#include "Telemetry.h"
+#include "WorkerPool.h"
+
 #define PARAMETER_ID(str) constexpr const char*(str){#str}; // NOLINT
 
+namespace ID
+{
 PARAMETER_ID(inputGain)
 PARAMETER_ID(outputGain)
 PARAMETER_ID(mix)
 PARAMETER_ID(processor2Enabled)
-PARAMETER_ID(processor2Type)
-PARAMETER_ID(processor2Oversampler)
+PARAMETER_ID(processor2Shaper)
+PARAMETER_ID(processor2Oversampling)
 PARAMETER_ID(processor2Lowpass)
 PARAMETER_ID(processor2Highpass)
 PARAMETER_ID(processor2InGain)
 PARAMETER_ID(processor2CompGain)
 PARAMETER_ID(processor2Mix)
+PARAMETER_ID(processor2Interpolation)
+PARAMETER_ID(processor2Antialiasing)
+PARAMETER_ID(automationMode)
+PARAMETER_ID(channelGroups)
+PARAMETER_ID(offlineBlockSize)
+PARAMETER_ID(offlineQuality)
+} // namespace ID
+
+// Parameters that got more choices moved to a new ID, as hosts store automation normalised
+// and the old values would land on other choices. Sessions still carry these IDs, whose
+// choices kept their indices, see setStateInformation.
+namespace LegacyID
+{
+PARAMETER_ID(processor2Type)        // "Tanh" and "Fast tanh", now processor2Shaper
+PARAMETER_ID(processor2Oversampler) // up to "8x int. latency", now processor2Oversampling
+} // namespace LegacyID
 
 #undef PARAMETER_ID
-} // namespace ID
 
 template <typename Func, typename... Items>
 constexpr void forEach(Func&& func, Items&&... items)
@@ -48,7 +76,8 @@ void resetAll(Processors&... processors)
 //==============================================================================
 class PluginProcessor final
     : public AudioProcessor
-    , public AudioProcessorValueTreeState::Listener
+    , private AudioProcessorParameter::Listener
+    , private AsyncUpdater
 {
   public:
     PluginProcessor()
@@ -56,6 +85,12 @@ class PluginProcessor final
     {
     }
 
+    ~PluginProcessor() override
+    {
+        // a latency report still queued must not reach a half-destroyed processor
+        cancelPendingUpdate();
+    }
+
     //==============================================================================
     void prepareToPlay(double sampleRate, int samplesPerBlock) final
     {
@@ -64,19 +99,72 @@ class PluginProcessor final
         if (channels == 0)
             return;
 
-        chain.prepare({sampleRate, (uint32)samplesPerBlock, (uint32)channels});
+        const auto numGroups = jlimit(1, jmin(channels, SystemStats::getNumCpus()), getChannelGroupCount(channels));
+
+        // the offline settings, see setOfflineBlockSize and setOfflineHighQuality
+        const auto& settings = parameters.settingsGroup;
+        const auto accumulatorSize = isNonRealtime() ? getOfflineBlockSize() : 0;
+        const auto maximumBlockSize = jmax(samplesPerBlock, accumulatorSize);
+        highQualityRendering = isNonRealtime() && settings.offlineQuality.getIndex() == 1;
 
-        mix = std::make_unique<dsp::DryWetMixer<float>>(samplesPerBlock);
-        mix->prepare({sampleRate, (uint32)samplesPerBlock, (uint32)channels});
-        mix->setMixingRule(dsp::DryWetMixingRule::linear);
+        // the engines are built here rather than in the constructor, and only for the
+        // precision in use, so instances the host never prepares stay small
+        forActiveEngines([&](auto& engines) { resizeEngines(engines, numGroups); });
+
+        if (isUsingDoublePrecision())
+            floatEngines.clear();
+        else
+            doubleEngines.clear();
+
+        if (numGroups == 1)
+            workers.reset();
+        else if (workers == nullptr || workers->getNumWorkers() != numGroups - 1)
+            workers = std::make_unique<WorkerPool>(numGroups - 1);
+
+        // pick up the oversampling factor first, it is the only one built up front
+        update(allParameters);
+
+        // only the engines matching the host's processing precision are prepared
+        forActiveEngines(
+            [&](auto& engines)
+            {
+                for (auto group = 0; group < numGroups; ++group)
+                {
+                    const auto range = getChannelGroup(group, numGroups, channels);
+                    engines[(size_t)group]->prepare(
+                        {sampleRate, (uint32)maximumBlockSize, (uint32)range.getLength()}, highQualityRendering
+                    );
+                }
+            }
+        );
+
+        floatAccumulator.prepare(channels, isUsingDoublePrecision() ? 0 : accumulatorSize);
+        doubleAccumulator.prepare(channels, isUsingDoublePrecision() ? accumulatorSize : 0);
+
+        // everything sized above, in one block that processing never resizes
+        stateArena.build(
+            [this](StateArena& arena)
+            {
+                forEachActiveEngine([&](auto& engine) { engine.allocate(arena); });
+                floatAccumulator.allocate(arena);
+                doubleAccumulator.allocate(arena);
+            }
+        );
 
         reset();
+
+        // hosts read the latency right after this returns, so it can't wait for the message loop
+        forActiveEngines([this](auto& engines) { latencySamples.store(getTotalLatency(engines)); });
+        setLatencySamples(latencySamples.load());
     }
 
     void reset() final
     {
-        chain.reset();
-        update();
+        forEachActiveEngine([](auto& engine) { engine.reset(); });
+        resetAll(floatAccumulator, doubleAccumulator);
+        update(allParameters);
+
+        samplePosition = 0;
     }
 
     void releaseResources() final
@@ -85,37 +173,117 @@ class PluginProcessor final
 
     void processBlock(AudioBuffer<float>& buffer, MidiBuffer&) final
     {
-        if (jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()) == 0)
-            return;
+        process(buffer, floatEngines);
+    }
 
-        ScopedNoDenormals noDenormals;
+    void processBlock(AudioBuffer<double>& buffer, MidiBuffer&) final
+    {
+        process(buffer, doubleEngines);
+    }
 
-        if (requiresUpdate.load())
-            update();
+    bool supportsDoublePrecisionProcessing() const final
+    {
+        return true;
+    }
 
-        const auto totalNumInputChannels = getTotalNumInputChannels();
-        const auto totalNumOutputChannels = getTotalNumOutputChannels();
+    //==============================================================================
+    enum class AutomationMode
+    {
+        perBlock, // parameters are read once per host block, the default
+        subBlock  // and at every automationInterval samples of the song position
+    };
 
-        setLatencySamples(
-            dsp::isBypassed<processor2Index>(chain) ? 0 : roundToInt(dsp::get<processor2Index>(chain).getLatency())
-        );
+    static constexpr int automationInterval = 32;
+
+    // Sub-block mode makes the result independent of the host's block size, at the cost of
+    // running the chain on shorter blocks, so only sessions that want sample-accurate
+    // automation should turn it on. This sets the "Automation" setting, as a host would.
+    void setAutomationMode(AutomationMode newMode)
+    {
+        parameters.settingsGroup.automation = (int)newMode;
+    }
+
+    // Wide buses can be split into up to this many channel groups, each with its own engine,
+    // processed in parallel on real-time worker threads. The groups read the parameters once
+    // per host block, so the output is the same as with one group in AutomationMode::perBlock
+    // only. Takes effect at the next prepareToPlay. This sets the "Channel groups" setting to
+    // the largest choice not above `newMaxChannelGroups`, 0 or less picks "Auto", the default,
+    // which gives every autoChannelsPerGroup channels a group.
+    void setMaxChannelGroups(int newMaxChannelGroups)
+    {
+        auto& setting = parameters.settingsGroup.channelGroups;
+        auto index = newMaxChannelGroups > 0 ? 1 : 0;
 
-        const auto numChannels = jmax(totalNumInputChannels, totalNumOutputChannels);
+        // choice `index` allows 1 << (index - 1) groups
+        while (index > 0 && index < setting.choices.size() - 1 && (1 << index) <= newMaxChannelGroups)
+            ++index;
 
-        auto inoutBlock = dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t)numChannels);
+        setting = index;
+    }
+
+    static constexpr int autoChannelsPerGroup = 8; // so stereo up to 7.1 stays serial
+
+    // Offline renders (isNonRealtime() at prepareToPlay) can gather the host's blocks into
+    // blocks of this many samples, so the oversamplers and filters run on long blocks however
+    // short the host's are. That adds as much latency, which is reported to the host, and
+    // parameter changes then land once per internal block. Takes effect at the next
+    // prepareToPlay. This sets the "Offline block size" setting to the largest choice not
+    // above `newBlockSize`; "Host", the default, or anything below 512 turns it off.
+    void setOfflineBlockSize(int newBlockSize)
+    {
+        auto& setting = parameters.settingsGroup.offlineBlockSize;
+        auto index = 0;
 
-        mix->setWetLatency((float)getLatencySamples());
-        mix->pushDrySamples(inoutBlock);
+        while (index < setting.choices.size() - 1 && getOfflineBlockSize(index + 1) <= newBlockSize)
+            ++index;
 
-        chain.process(dsp::ProcessContextReplacing<float>(inoutBlock));
+        setting = index;
+    }
 
-        mix->mixWetSamples(inoutBlock);
+    // Offline renders can also swap the tanh approximations for std::tanh and the IIR
+    // oversamplers for linear-phase FIR ones of the same factor, which adds latency.
+    // Takes effect at the next prepareToPlay; sets the "Offline quality" setting.
+    void setOfflineHighQuality(bool highQuality)
+    {
+        parameters.settingsGroup.offlineQuality = highQuality ? 1 : 0;
     }
 
-    void processBlock(AudioBuffer<double>&, MidiBuffer&) final
+    // Editors turn this on while they show meters; blocks are only measured meanwhile.
+    void setTelemetryEnabled(bool enabled) noexcept
     {
+        telemetryEnabled.store(enabled);
     }
 
+    // One frame per processed block, for a single reader on the message thread.
+    Telemetry::Fifo& getTelemetry() noexcept
+    {
+        return telemetry;
+    }
+
+    // Bytes of DSP state held in one block since the last prepareToPlay, see StateArena.h.
+    size_t getStateArenaSize() const noexcept
+    {
+        return stateArena.getSize();
+    }
+
+    // Processor2's waveshaper alone, in place, for the processor2Shaper choice `typeIndex`;
+    // e.g. for drawing its transfer curve. The caller holds the tables, so they aren't
+    // rebuilt for every call when no engine does.
+    static void applyWaveshaper(
+        const dsp::AudioBlock<float>& block, int typeIndex, const ShaperTables::Tables<float>& tables
+    )
+    {
+        Processor2<float>::shape(block, typeIndex, tables, ShaperTables::Interpolation::cubic);
+    }
+
+   #if MY_STAGE_PROFILING
+    // How long each stage of the audio path takes in this instance, see StageProfiler.h.
+    StageProfiler::Histograms& getStageHistograms() noexcept
+    {
+        return stageHistograms;
+    }
+   #endif
+
     //==============================================================================
     AudioProcessorEditor* createEditor() override;
 
@@ -189,17 +357,69 @@ class PluginProcessor final
     //==============================================================================
     void getStateInformation(MemoryBlock& destData) final
     {
-        copyXmlToBinary(*apvts.copyState().createXml(), destData);
+        std::vector<StateFormat::Entry> entries;
+        entries.reserve((size_t)getParameters().size());
+
+        parameters.forEachParameter(
+            [&](const RangedAudioParameter& param)
+            {
+                entries.push_back(
+                    {StateFormat::hashParameterId(param.getParameterID()), param.convertFrom0to1(param.getValue())}
+                );
+            }
+        );
+
+        StateFormat::write(destData, entries);
     }
 
     void setStateInformation(const void* data, int sizeInBytes) final
     {
-        apvts.replaceState(ValueTree::fromXml(*getXmlFromBinary(data, sizeInBytes)));
-    }
+        if (const auto entries = StateFormat::read(data, sizeInBytes))
+        {
+            const auto find = [&](const String& parameterId)
+            {
+                const auto id = StateFormat::hashParameterId(parameterId);
+                return std::find_if(entries->begin(), entries->end(), [id](const auto& e) { return e.id == id; });
+            };
 
-    void parameterChanged(const String&, float) final
-    {
-        requiresUpdate.store(true);
+            // parameters missing from the state go back to their defaults, as with the XML
+            parameters.forEachParameter(
+                [&](RangedAudioParameter& param)
+                {
+                    auto entry = find(param.getParameterID());
+
+                    if (const auto* legacyId = getLegacyParameterId(param); entry == entries->end() && legacyId)
+                        entry = find(legacyId);
+
+                    param.setValueNotifyingHost(
+                        entry != entries->end() ? param.convertTo0to1(entry->value) : param.getDefaultValue()
+                    );
+                }
+            );
+
+            return;
+        }
+
+        // sessions saved before the binary format
+        if (const auto xml = getXmlFromBinary(data, sizeInBytes))
+        {
+            auto state = ValueTree::fromXml(*xml);
+
+            parameters.forEachParameter(
+                [&](const RangedAudioParameter& param)
+                {
+                    const auto* legacyId = getLegacyParameterId(param);
+
+                    if (legacyId == nullptr || state.getChildWithProperty("id", param.getParameterID()).isValid())
+                        return;
+
+                    if (auto legacy = state.getChildWithProperty("id", legacyId); legacy.isValid())
+                        legacy.setProperty("id", param.getParameterID(), nullptr);
+                }
+            );
+
+            apvts.replaceState(state);
+        }
     }
 
     using Parameter = AudioProcessorValueTreeState::Parameter;
@@ -242,6 +462,12 @@ class PluginProcessor final
             return str.getFloatValue();
         }
 
+        // settings are saved with the session and listed by the host, but not automatable
+        static auto getSettingAttributes()
+        {
+            return AudioParameterChoiceAttributes().withAutomatable(false);
+        }
+
         static auto getBasicAttributes()
         {
             return Attributes()
@@ -330,9 +556,16 @@ class PluginProcessor final
                   ))
                 , type(addToLayout<AudioParameterChoice>( //
                       layout,
-                      ParameterID{ID::processor2Type, 1},
-                      "someChoice",
-                      StringArray{"choice1", "choice2"},
+                      ParameterID{ID::processor2Shaper, 2},
+                      "Shaper",
+                      StringArray{"Tanh", "Fast tanh", "Asymmetric", "Soft knee", "Foldback", "Hard clip"},
+                      0
+                  ))
+                , oversampler(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::processor2Oversampling, 2},
+                      "Oversampling",
+                      StringArray{"2x", "4x", "8x", "2x int. latency", "4x int. latency", "8x int. latency", "1x"},
                       0
                   ))
                 , inGain(addToLayout<Parameter>(
@@ -375,26 +608,115 @@ class PluginProcessor final
                       100.0f,
                       getPercentageAttributes()
                   ))
+                , interpolation(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::processor2Interpolation, 1},
+                      "Interpolation",
+                      StringArray{"Linear", "Cubic"},
+                      1
+                  ))
+                , antialiasing(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::processor2Antialiasing, 1},
+                      "Anti-aliasing",
+                      StringArray{"Off", "ADAA 1st order", "ADAA 2nd order"},
+                      0
+                  ))
             {
             }
 
             AudioParameterBool& enabled;
             AudioParameterChoice& type;
+            AudioParameterChoice& oversampler;
             Parameter& inGain;
             Parameter& lowpass;
             Parameter& highpass;
             Parameter& compGain;
             Parameter& mix;
+            AudioParameterChoice& interpolation; // for the table-driven shapers
+            AudioParameterChoice& antialiasing; // ADAA order, for the tanh and hard clip shapers
+        };
+
+        // How the plugin runs rather than what it does; see the setters these back.
+        struct SettingsGroup
+        {
+            explicit SettingsGroup(AudioProcessorParameterGroup& layout)
+                : automation(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::automationMode, 2},
+                      "Automation",
+                      StringArray{"Per block", "Sample accurate"},
+                      0,
+                      getSettingAttributes()
+                  ))
+                , channelGroups(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::channelGroups, 2},
+                      "Channel groups",
+                      StringArray{"Auto", "1", "2", "4", "8", "16", "32", "64"},
+                      0,
+                      getSettingAttributes()
+                  ))
+                , offlineBlockSize(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::offlineBlockSize, 2},
+                      "Offline block size",
+                      StringArray{"Host", "512", "1024", "2048", "4096", "8192"},
+                      0,
+                      getSettingAttributes()
+                  ))
+                , offlineQuality(addToLayout<AudioParameterChoice>( //
+                      layout,
+                      ParameterID{ID::offlineQuality, 2},
+                      "Offline quality",
+                      StringArray{"Realtime", "High"},
+                      0,
+                      getSettingAttributes()
+                  ))
+            {
+            }
+
+            AudioParameterChoice& automation; // an AutomationMode
+            AudioParameterChoice& channelGroups; // "Auto", then 1 << (index - 1) groups at most
+            AudioParameterChoice& offlineBlockSize; // "Host", then 256 << index samples
+            AudioParameterChoice& offlineQuality;
         };
 
         explicit ParameterReferences(AudioProcessorValueTreeState::ParameterLayout& layout)
             : mainGroup(addToLayout<AudioProcessorParameterGroup>(layout, "main", "Main", "|"))
             , processor2Group(addToLayout<AudioProcessorParameterGroup>(layout, "processor2", "Processor2", "|"))
+            , settingsGroup(addToLayout<AudioProcessorParameterGroup>(layout, "settings", "Settings", "|"))
+        {
+        }
+
+        template <typename Func>
+        void forEachParameter(Func&& func) const
         {
+            forEach(
+                func,
+                mainGroup.inputGain,
+                mainGroup.outputGain,
+                mainGroup.mix,
+                processor2Group.enabled,
+                processor2Group.type,
+                processor2Group.oversampler,
+                processor2Group.inGain,
+                processor2Group.lowpass,
+                processor2Group.highpass,
+                processor2Group.compGain,
+                processor2Group.mix,
+                processor2Group.interpolation,
+                processor2Group.antialiasing,
+                settingsGroup.automation,
+                settingsGroup.channelGroups,
+                settingsGroup.offlineBlockSize,
+                settingsGroup.offlineQuality
+            );
         }
 
         MainGroup mainGroup;
         Processor2Group processor2Group;
+        SettingsGroup settingsGroup;
     };
 
     const ParameterReferences& getParameterValues() const noexcept
@@ -402,6 +724,12 @@ class PluginProcessor final
         return parameters;
     }
 
+    // The tree the parameters live in; sessions saved before StateFormat hold its XML.
+    AudioProcessorValueTreeState& getValueTreeState() noexcept
+    {
+        return apvts;
+    }
+
     //==============================================================================
     // We store this here so that the editor retains its state if it is closed and reopened
     int indexTab = 0;
@@ -414,46 +742,328 @@ class PluginProcessor final
         , parameters{layout}
         , apvts{*this, nullptr, "state", std::move(layout)}
     {
-        // why
-        for (auto i = 0; i < apvts.state.getNumChildren(); ++i)
+        // one dirty bit per parameter index
+        jassert(getParameters().size() <= 32);
+
+        parameters.forEachParameter([this](AudioProcessorParameter& param) { param.addListener(this); });
+    }
+
+    // The ID `param` had in older sessions, see LegacyID, or nullptr.
+    const char* getLegacyParameterId(const AudioProcessorParameter& param) const
+    {
+        if (&param == &parameters.processor2Group.type)
+            return LegacyID::processor2Type;
+
+        if (&param == &parameters.processor2Group.oversampler)
+            return LegacyID::processor2Oversampler;
+
+        return nullptr;
+    }
+
+    // Any thread, including the audio thread while automating.
+    void parameterValueChanged(int parameterIndex, float) final
+    {
+        dirtyParameters.fetch_or((uint32)1 << parameterIndex);
+    }
+
+    void parameterGestureChanged(int, bool) final
+    {
+    }
+
+    // Message thread, after the audio thread saw the latency change, see beginSubBlock.
+    // Hosts may treat any call as a latency change, so only real changes are reported.
+    void handleAsyncUpdate() final
+    {
+        if (const auto latency = latencySamples.load(); latency != getLatencySamples())
+            setLatencySamples(latency);
+    }
+
+    //==============================================================================
+    template <typename SampleType, typename EnginesType>
+    void process(AudioBuffer<SampleType>& buffer, EnginesType& engines)
+    {
+        const auto numChannels = jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+        // not prepared for this precision
+        if (numChannels == 0 || engines.empty())
+            return;
+
+        MY_REALTIME_SCOPE;
+        MY_PROFILE_INSTANCE(stageHistograms);
+        ScopedNoDenormals noDenormals;
+
+        auto block = dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t)numChannels);
+        const auto metering = telemetryEnabled.load(std::memory_order_relaxed);
+
+        // internal blocks are processed whole, splitting them would defeat their purpose
+        if (auto& accumulator = getAccumulator(engines); accumulator.isActive())
+            accumulator.process(block, [&](auto& fullBlock) { processEngines(fullBlock, engines, metering, false); });
+        else
+            processEngines(block, engines, metering, getAutomationMode() == AutomationMode::subBlock);
+
+        if (metering)
+            pushTelemetry(engines, buffer.getNumSamples());
+    }
+
+    template <typename SampleType, typename EnginesType>
+    void processEngines(dsp::AudioBlock<SampleType>& block, EnginesType& engines, bool metering, bool splitBlocks)
+    {
+        const auto numChannels = (int)block.getNumChannels();
+        const auto position = samplePosition;
+        samplePosition += (int64)block.getNumSamples();
+
+        if (engines.size() == 1)
+        {
+            auto& engine = *engines.front();
+
+            forEachSubBlock(
+                block,
+                position,
+                splitBlocks,
+                [&](auto& subBlock) { engine.process(subBlock, beginSubBlock(engines), metering); }
+            );
+        }
+        else
         {
-            auto child = apvts.state.getChild(i);
-            auto childType = child.getType();
-            if (childType == Identifier("PARAM"))
+            // groups read the parameters once per block, so all of them see the same values
+            const auto oversamplerReady = beginSubBlock(engines);
+            const auto numGroups = (int)engines.size();
+
+            auto processGroup = [&](int group)
             {
-                auto name = child.getProperty("id").toString();
-                if (auto* param = apvts.getParameter(name))
-                    apvts.addParameterListener(name, this);
-            }
+                MY_REALTIME_SCOPE;
+                MY_PROFILE_INSTANCE(stageHistograms);
+                ScopedNoDenormals groupNoDenormals;
+
+                const auto range = getChannelGroup(group, numGroups, numChannels);
+                auto groupBlock = block.getSubsetChannelBlock((size_t)range.getStart(), (size_t)range.getLength());
+                auto& engine = *engines[(size_t)group];
+
+                forEachSubBlock(
+                    groupBlock,
+                    position,
+                    splitBlocks,
+                    [&](auto& subBlock) { engine.process(subBlock, oversamplerReady, metering); }
+                );
+            };
+
+            workers->run(numGroups, processGroup);
         }
+    }
+
+    // The "Channel groups" setting for a bus this wide, before limiting it to the cores.
+    int getChannelGroupCount(int numChannels) const noexcept
+    {
+        if (const auto index = parameters.settingsGroup.channelGroups.getIndex(); index > 0)
+            return 1 << (index - 1);
+
+        return numChannels / autoChannelsPerGroup;
+    }
+
+    // Samples per internal block for the "Offline block size" choice `index`, 0 for "Host".
+    static int getOfflineBlockSize(int index) noexcept
+    {
+        return index > 0 ? 256 << index : 0;
+    }
+
+    int getOfflineBlockSize() const noexcept
+    {
+        return getOfflineBlockSize(parameters.settingsGroup.offlineBlockSize.getIndex());
+    }
+
+    AutomationMode getAutomationMode() const noexcept
+    {
+        return (AutomationMode)parameters.settingsGroup.automation.getIndex();
+    }
+
+    // Combines the levels every channel group measured into one frame for the editor.
+    template <typename EnginesType>
+    void pushTelemetry(EnginesType& engines, int numSamples)
+    {
+        Telemetry::Accumulator input, output;
+
+        for (auto& engine : engines)
+        {
+            input.merge(engine->inputLevels);
+            output.merge(engine->outputLevels);
+            engine->inputLevels.clear();
+            engine->outputLevels.clear();
+        }
+
+        telemetry.push({input.getLevels(), output.getLevels(), numSamples});
+    }
+
+    // Sub-blocks end on multiples of automationInterval counted from reset(), so parameter
+    // changes land on the same samples whatever the host block size.
+    template <typename SampleType, typename Func>
+    static void forEachSubBlock(dsp::AudioBlock<SampleType>& block, int64 position, bool splitBlocks, Func&& func)
+    {
+        const auto numSamples = (int)block.getNumSamples();
+
+        for (auto start = 0; start < numSamples;)
+        {
+            auto length = numSamples - start;
 
-        forEach(
-            [](dsp::Gain<float>& gain) { gain.setRampDurationSeconds(0.05); },
-            dsp::get<inputGainIndex>(chain),
-            dsp::get<outputGainIndex>(chain)
+            if (splitBlocks)
+                length = jmin(length, automationInterval - (int)(position % automationInterval));
+
+            auto subBlock = block.getSubBlock((size_t)start, (size_t)length);
+            func(subBlock);
+
+            start += length;
+            position += length;
+        }
+    }
+
+    // Applies parameter changes and reports the latency. Returns whether every engine has
+    // the requested oversampler built, so they all switch on the same sample.
+    template <typename EnginesType>
+    bool beginSubBlock(EnginesType& engines)
+    {
+        if (const auto dirty = dirtyParameters.exchange(0); dirty != 0)
+            update(dirty);
+
+        // Exempt from the real-time check on purpose: the updater's message is allocated once
+        // with it and only posted when none is pending, but posting takes the message queue's
+        // lock (a system call on some platforms) and may grow the queue. That only happens on
+        // real latency changes, when the oversampling, ADAA or Processor2 is switched, never
+        // while automating anything else, and the host has to be told about those anyway.
+        if (const auto latency = getTotalLatency(engines); latencySamples.exchange(latency) != latency)
+        {
+            MY_REALTIME_EXEMPTION;
+            triggerAsyncUpdate();
+        }
+
+        return std::all_of(
+            engines.begin(), engines.end(), [](auto& engine) { return engine->processor2.isOversamplerReady(); }
         );
     }
 
+    // What the host has to compensate for: the engines' latency plus any offline accumulation.
+    template <typename EnginesType>
+    int getTotalLatency(EnginesType& engines)
+    {
+        return roundToInt(engines.front()->getLatency()) + getAccumulator(engines).getLatency();
+    }
+
+    // The accumulator matching the engines' sample type.
+    template <typename EnginesType>
+    auto& getAccumulator(EnginesType&)
+    {
+        if constexpr (std::is_same_v<typename EnginesType::value_type::element_type::SampleType, float>)
+            return floatAccumulator;
+        else
+            return doubleAccumulator;
+    }
+
+    static Range<int> getChannelGroup(int group, int numGroups, int numChannels)
+    {
+        return {group * numChannels / numGroups, (group + 1) * numChannels / numGroups};
+    }
+
     //==============================================================================
-    void update()
+    // Pushes the parameters whose bits are set in `dirty` into the active engines.
+    void update(uint32 dirty)
     {
+        forEachActiveEngine([&](auto& engine) { update(engine, dirty); });
+    }
+
+    template <typename EngineType>
+    void update(EngineType& engine, uint32 dirty)
+    {
+        using SampleType = typename EngineType::SampleType;
+
+        const auto changed = [dirty](const AudioProcessorParameter& param)
+        { return (dirty >> param.getParameterIndex() & 1) != 0; };
+
         {
-            Processor2& processor2 = dsp::get<processor2Index>(chain);
+            const auto& state = parameters.processor2Group;
+            auto& processor2 = engine.processor2;
 
-            processor2.currentIndexWaveshaper = parameters.processor2Group.type.getIndex();
-            processor2.lowpass.setCutoffFrequency(parameters.processor2Group.lowpass.get());
-            processor2.highpass.setCutoffFrequency(parameters.processor2Group.highpass.get());
-            processor2.distGain.setGainDecibels(parameters.processor2Group.inGain.get());
-            processor2.compGain.setGainDecibels(parameters.processor2Group.compGain.get());
-            processor2.mixer.setWetMixProportion(parameters.processor2Group.mix.get() / 100.0f);
-            dsp::setBypassed<processor2Index>(chain, !parameters.processor2Group.enabled);
+            if (changed(state.type))
+            {
+                processor2.setWaveshaperIndex(state.type.getIndex());
+                processor2.preciseShaper = highQualityRendering;
+            }
+
+            if (changed(state.interpolation))
+                processor2.interpolation = (ShaperTables::Interpolation)state.interpolation.getIndex();
+
+            if (changed(state.antialiasing))
+                processor2.setAntialiasingOrder(state.antialiasing.getIndex());
+
+            if (changed(state.oversampler))
+            {
+                const auto index = state.oversampler.getIndex();
+                processor2.setOversamplingIndex(
+                    highQualityRendering ? OversamplerBank<SampleType>::getLinearPhaseIndex(index) : index,
+                    isNonRealtime()
+                );
+            }
+
+            if (changed(state.lowpass))
+                processor2.lowpassCutoff.setTargetValue(state.lowpass.get());
+
+            if (changed(state.highpass))
+                processor2.highpassCutoff.setTargetValue(state.highpass.get());
+
+            if (changed(state.inGain))
+                processor2.distGain.setGainDecibels(state.inGain.get());
+
+            if (changed(state.compGain))
+                processor2.compGain.setGainDecibels(state.compGain.get());
+
+            if (changed(state.mix))
+                processor2.mix.setTargetValue(state.mix.get() / (SampleType)100);
+
+            if (changed(state.enabled))
+                engine.setProcessor2Enabled(state.enabled);
         }
 
-        dsp::get<inputGainIndex>(chain).setGainDecibels(parameters.mainGroup.inputGain.get());
-        dsp::get<outputGainIndex>(chain).setGainDecibels(parameters.mainGroup.outputGain.get());
-        mix->setWetMixProportion(parameters.mainGroup.mix.get() / 100.0f);
+        const auto& state = parameters.mainGroup;
+
+        if (changed(state.inputGain))
+            engine.inputGain.setTargetValue(Decibels::decibelsToGain((SampleType)state.inputGain.get()));
 
-        requiresUpdate.store(false);
+        if (changed(state.outputGain))
+            engine.outputGain.setGainDecibels(state.outputGain.get());
+
+        if (changed(state.mix))
+            engine.mix.setTargetValue(state.mix.get() / (SampleType)100);
+    }
+
+    // The engines matching the host's processing precision, see prepareToPlay.
+    template <typename Func>
+    void forActiveEngines(Func&& func)
+    {
+        if (isUsingDoublePrecision())
+            func(doubleEngines);
+        else
+            func(floatEngines);
+    }
+
+    template <typename Func>
+    void forEachActiveEngine(Func&& func)
+    {
+        forActiveEngines(
+            [&](auto& engines)
+            {
+                for (auto& engine : engines)
+                    func(*engine);
+            }
+        );
+    }
+
+    // Message thread; new engines get their parameters from the full update that follows.
+    template <typename EnginesType>
+    static void resizeEngines(EnginesType& engines, int numGroups)
+    {
+        using EngineType = typename EnginesType::value_type::element_type;
+
+        while ((int)engines.size() < numGroups)
+            engines.push_back(std::make_unique<EngineType>());
+
+        engines.resize((size_t)numGroups);
     }
 
     //==============================================================================
@@ -491,126 +1101,620 @@ class PluginProcessor final
     }
 
     //==============================================================================
+    using Stage = StageProfiler::Stage;
+
+    template <typename SampleType>
     struct Processor2
     {
         Processor2()
         {
-            forEach([](dsp::Gain<float>& gain) { gain.setRampDurationSeconds(0.05); }, distGain, compGain);
+            forEach([](dsp::Gain<SampleType>& gain) { gain.setRampDurationSeconds(0.05); }, distGain, compGain);
 
             lowpass.setType(dsp::FirstOrderTPTFilterType::lowpass);
             highpass.setType(dsp::FirstOrderTPTFilterType::highpass);
-            mixer.setMixingRule(dsp::DryWetMixingRule::linear);
         }
 
         void prepare(const dsp::ProcessSpec& spec)
         {
-            for (auto& oversampler : oversamplers)
-                oversampler.initProcessing(spec.maximumBlockSize);
+            oversamplers.prepare(spec, requestedIndexOversampling);
+            currentIndexOversampling = requestedIndexOversampling;
+
+            prepareAll(spec, lowpass, highpass, distGain, compGain);
+
+            lowpassCutoff.reset(spec.sampleRate, 0.05);
+            highpassCutoff.reset(spec.sampleRate, 0.05);
+            mix.reset(spec.sampleRate, 0.05);
+
+            oversamplingFade.reset(spec.sampleRate, 0.02);
+
+            for (auto& shaper : adaaShapers)
+                shaper.prepare((int)spec.numChannels);
+
+            preparedSpec = spec;
+        }
+
+        void allocate(StateArena& arena)
+        {
+            // the outgoing oversampler renders into this while a factor change fades over
+            arena.allocate(fadeBuffer, (int)preparedSpec.numChannels, (int)preparedSpec.maximumBlockSize);
+            arena.allocate(fadeRamp, 1, (int)preparedSpec.maximumBlockSize);
 
-            prepareAll(spec, lowpass, highpass, distGain, compGain, mixer);
+            for (auto& shaper : adaaShapers)
+                shaper.allocate(arena);
         }
 
         void reset()
         {
-            for (auto& oversampler : oversamplers)
-                oversampler.reset();
+            oversamplers.reset();
+
+            for (auto& shaper : adaaShapers)
+                shaper.reset();
+
+            resetAll(lowpass, highpass, distGain, compGain);
+
+            lowpassCutoff.setCurrentAndTargetValue(lowpassCutoff.getTargetValue());
+            highpassCutoff.setCurrentAndTargetValue(highpassCutoff.getTargetValue());
+            mix.setCurrentAndTargetValue(mix.getTargetValue());
+            lowpass.setCutoffFrequency(lowpassCutoff.getTargetValue());
+            highpass.setCutoffFrequency(highpassCutoff.getTargetValue());
+
+            // a pending factor change is left to process(), which fades over to it
+            previousIndexOversampling = -1;
+            oversamplingFade.setCurrentAndTargetValue(1);
+        }
+
+        // ADAA is late by a fraction of a sample at the oversampled rate
+        SampleType getLatency() const
+        {
+            return getLatency(currentIndexOversampling);
+        }
+
+        SampleType getLatency(int indexOversampling) const
+        {
+            const auto& oversampler = oversamplers[indexOversampling];
+            const auto shaperDelay = isAntialiased() ? Adaa::getDelay(antialiasingOrder) : 0.0;
+
+            return oversampler.getLatencyInSamples()
+                 + (SampleType)(shaperDelay / (double)oversampler.getOversamplingFactor());
+        }
+
+        // Audio thread. 0 for off, otherwise the ADAA order; only the tanh and hard clip
+        // shapers have one. Starts from a clean history.
+        void setAntialiasingOrder(int order)
+        {
+            antialiasingOrder = jlimit(0, Adaa::maximumOrder, order);
 
-            resetAll(lowpass, highpass, distGain, compGain, mixer);
+            for (auto& shaper : adaaShapers)
+                shaper.reset();
         }
 
-        float getLatency() const
+        // Audio thread. The ADAA histories hold antiderivatives of the old curve, which would
+        // make the first differences of the new one jump far past full scale, so a new shaper
+        // starts them afresh.
+        void setWaveshaperIndex(int index)
         {
-            return oversamplers[size_t(currentIndexOversampling)].getLatencyInSamples();
+            if (index == currentIndexWaveshaper)
+                return;
+
+            currentIndexWaveshaper = index;
+
+            for (auto& shaper : adaaShapers)
+                shaper.reset();
         }
 
-        template <typename Context>
-        void process(Context& context)
+        bool isAntialiased() const
         {
-            if (context.isBypassed)
+            return antialiasingOrder > 0 && isPositiveAndBelow(currentIndexWaveshaper, shapers.size())
+                && shapers[(size_t)currentIndexWaveshaper].antiderivative.has_value();
+        }
+
+        // Audio thread. The switch happens at the start of the next block that isn't already
+        // fading and finds the new oversampler built, so every change gets a full crossfade.
+        // Offline renders build it right here instead, so they switch at the same sample every time.
+        void setOversamplingIndex(int index, bool buildNow)
+        {
+            if (!isPositiveAndBelow(index, oversamplers.size()))
                 return;
 
-            const auto& inputBlock = context.getInputBlock();
+            requestedIndexOversampling = index;
+
+            if (buildNow)
+                oversamplers.build(index);
+            else
+                oversamplers.request(index);
+        }
 
-            mixer.setWetLatency(getLatency());
-            mixer.pushDrySamples(inputBlock);
+        // Audio thread. True once the requested oversampler is built, see setOversamplingIndex.
+        bool isOversamplerReady()
+        {
+            return oversamplers.request(requestedIndexOversampling);
+        }
 
-            distGain.process(context);
-            highpass.process(context);
+        // Audio thread, ahead of the dry path and process(). Starts a pending factor change
+        // once the owner says the oversampler is ready, so channel groups all switch together.
+        // While a change fades over, returns the fade for the next numSamples samples, so the
+        // dry path can fade from the outgoing latency along with the wet signal.
+        const SampleType* beginBlock(int numSamples, bool oversamplerReady)
+        {
+            if (previousIndexOversampling < 0 && requestedIndexOversampling != currentIndexOversampling
+                && oversamplerReady)
+                startOversamplingFade();
 
-            auto ovBlock = oversamplers[size_t(currentIndexOversampling)].processSamplesUp(inputBlock);
+            if (previousIndexOversampling < 0)
+                return nullptr;
 
-            dsp::ProcessContextReplacing<float> waveshaperContext(ovBlock);
+            auto* ramp = fadeRamp.getWritePointer(0);
 
-            if (isPositiveAndBelow(currentIndexWaveshaper, waveShapers.size()))
+            for (auto i = 0; i < numSamples; ++i)
+                ramp[i] = oversamplingFade.getNextValue();
+
+            return ramp;
+        }
+
+        // `dry` is the DryPath output: the block's input delayed by getLatency(), plus the
+        // input gain it went through in its last channel. `fade` is what beginBlock() returned.
+        void process(
+            dsp::AudioBlock<SampleType> block, const dsp::AudioBlock<const SampleType>& dry, const SampleType* fade
+        )
+        {
+            updateCutoffs((int)block.getNumSamples());
+
+            const dsp::ProcessContextReplacing<SampleType> context(block);
+
+            StageProfiler::measure(Stage::distGain, [&] { distGain.process(context); });
+            StageProfiler::measure(Stage::highpass, [&] { highpass.process(context); });
+
+            if (previousIndexOversampling >= 0)
+            {
+                auto fadeBlock = dsp::AudioBlock<SampleType>(fadeBuffer)
+                                     .getSubsetChannelBlock(0, block.getNumChannels())
+                                     .getSubBlock(0, block.getNumSamples());
+
+                fadeBlock.copyFrom(block);
+                processOversampled(previousIndexOversampling, fadeBlock);
+                processOversampled(currentIndexOversampling, block);
+                mixOversamplingFade(block, fadeBlock, fade);
+            }
+            else
             {
-                waveShapers[size_t(currentIndexWaveshaper)].process(waveshaperContext);
+                processOversampled(currentIndexOversampling, block);
+            }
 
-                if (currentIndexWaveshaper == 1)
-                    clipping.process(waveshaperContext);
+            StageProfiler::measure(Stage::lowpass, [&] { lowpass.process(context); });
+            StageProfiler::measure(Stage::compGain, [&] { compGain.process(context); });
+            StageProfiler::measure(Stage::processor2Mix, [&] { mixDry(block, dry); });
+        }
 
-                waveshaperContext.getOutputBlock() *= 0.7f;
+        // out = mix * out + (1 - mix) * inputGain * dry
+        void mixDry(dsp::AudioBlock<SampleType>& block, const dsp::AudioBlock<const SampleType>& dry)
+        {
+            if (!mix.isSmoothing() && mix.getTargetValue() >= (SampleType)1)
+                return;
+
+            const auto numChannels = block.getNumChannels();
+            const auto* gains = dry.getChannelPointer(numChannels);
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                const auto wet = mix.getNextValue();
+
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                {
+                    auto* samples = block.getChannelPointer(channel);
+                    const auto drySample = gains[i] * dry.getChannelPointer(channel)[i];
+                    samples[i] = drySample + wet * (samples[i] - drySample);
+                }
             }
+        }
+
+        // Cutoffs glide at control rate, one step per processed (sub-)block.
+        void updateCutoffs(int numSamples)
+        {
+            if (lowpassCutoff.isSmoothing())
+                lowpass.setCutoffFrequency(lowpassCutoff.skip(numSamples));
 
-            auto& outputBlock = context.getOutputBlock();
-            oversamplers[size_t(currentIndexOversampling)].processSamplesDown(outputBlock);
+            if (highpassCutoff.isSmoothing())
+                highpass.setCutoffFrequency(highpassCutoff.skip(numSamples));
+        }
 
-            lowpass.process(context);
-            compGain.process(context);
-            mixer.mixWetSamples(outputBlock);
+        // Each oversampler has its own ADAA history, as both run while a factor change fades over.
+        void processOversampled(int indexOversampling, dsp::AudioBlock<SampleType>& block)
+        {
+            auto& oversampler = oversamplers[indexOversampling];
+            auto ovBlock = StageProfiler::measure(Stage::upsample, [&] { return oversampler.processSamplesUp(block); });
+
+            StageProfiler::measure(
+                Stage::waveshaper,
+                [&]
+                {
+                    if (isAntialiased())
+                    {
+                        const auto function = *shapers[(size_t)currentIndexWaveshaper].antiderivative;
+                        adaaShapers[(size_t)indexOversampling].process(ovBlock, function, antialiasingOrder, trim);
+                    }
+                    else
+                    {
+                        shape(ovBlock, currentIndexWaveshaper, *tables, interpolation, preciseShaper);
+                    }
+                }
+            );
+
+            StageProfiler::measure(Stage::downsample, [&] { oversampler.processSamplesDown(block); });
         }
 
-        std::array<dsp::Oversampling<float>, 6> oversamplers{
+        // `precise` swaps the shape for std::tanh and the tables for their exact curves, see
+        // setOfflineHighQuality
+        static void shape(
+            const dsp::AudioBlock<SampleType>& block,
+            int indexWaveshaper,
+            const ShaperTables::Tables<SampleType>& tables,
+            ShaperTables::Interpolation interpolation,
+            bool precise = false
+        )
+        {
+            if (!isPositiveAndBelow(indexWaveshaper, shapers.size()))
+                return;
+
+            const auto& shaper = shapers[size_t(indexWaveshaper)];
+
+            if (!shaper.curve)
             {
-             {2, 1, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false},
-             {2, 2, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false},
-             {2, 3, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false},
-
-             {2, 1, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true},
-             {2, 2, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true},
-             {2, 3, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true},
-             }
-        };
+                const auto swap = precise && shaper.shape != ShaperKernels::Shape::identity;
+                const auto shape = swap ? ShaperKernels::Shape::preciseTanh : shaper.shape;
+                ShaperKernels::process(block, shape, shaper.clip, trim);
+            }
+            else if (precise)
+            {
+                ShaperTables::processExact(block, *shaper.curve, trim);
+            }
+            else
+            {
+                ShaperTables::process(block, tables[*shaper.curve], interpolation, trim);
+            }
+        }
+
+        void startOversamplingFade()
+        {
+            previousIndexOversampling = currentIndexOversampling;
+            currentIndexOversampling = requestedIndexOversampling;
+
+            // the incoming oversampler must not replay state from when it was last used
+            oversamplers[currentIndexOversampling].reset();
+            adaaShapers[(size_t)currentIndexOversampling].reset();
+
+            oversamplingFade.setCurrentAndTargetValue(0);
+            oversamplingFade.setTargetValue(1);
+        }
 
-        static float clip(float in)
+        // out = fade * out + (1 - fade) * outgoing
+        void mixOversamplingFade(
+            dsp::AudioBlock<SampleType>& block, const dsp::AudioBlock<SampleType>& outgoing, const SampleType* fade
+        )
         {
-            return juce::jlimit(-1.0f, 1.0f, in);
+            const auto numChannels = block.getNumChannels();
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                {
+                    auto* samples = block.getChannelPointer(channel);
+                    const auto old = outgoing.getChannelPointer(channel)[i];
+                    samples[i] = old + fade[i] * (samples[i] - old);
+                }
+            }
+
+            if (!oversamplingFade.isSmoothing())
+                previousIndexOversampling = -1;
         }
 
-        dsp::FirstOrderTPTFilter<float> lowpass, highpass;
-        dsp::Gain<float> distGain, compGain;
-        dsp::DryWetMixer<float> mixer{10};
-        std::array<dsp::WaveShaper<float>, 2> waveShapers{
-            {{std::tanh}, {dsp::FastMathApproximations::tanh}}
+        OversamplerBank<SampleType> oversamplers;
+        std::array<Adaa::Shaper<SampleType>, OversamplerBank<SampleType>::size()> adaaShapers; // one per oversampler
+
+        dsp::FirstOrderTPTFilter<SampleType> lowpass, highpass;
+        SmoothedValue<SampleType, ValueSmoothingTypes::Multiplicative> lowpassCutoff{22000}, highpassCutoff{20};
+        dsp::Gain<SampleType> distGain, compGain;
+        SmoothedValue<SampleType> mix{1}; // wet proportion
+
+        // indexed by processor2Shaper; shape, clip and trim run fused in one pass, a curve reads
+        // its shared table instead, and with anti-aliasing on the antiderivative replaces both
+        struct Shaper
+        {
+            ShaperKernels::Shape shape;
+            bool clip;
+            std::optional<ShaperTables::Curve> curve = {};
+            std::optional<Adaa::Function> antiderivative = {};
         };
-        dsp::WaveShaper<float> clipping{clip};
+
+        static constexpr std::array<Shaper, 6> shapers{{
+            {ShaperKernels::Shape::tanh, false, {}, Adaa::Function::tanh},
+            {ShaperKernels::Shape::fastTanh, true},
+            {ShaperKernels::Shape::tanh, false, ShaperTables::Curve::asymmetric},
+            {ShaperKernels::Shape::tanh, false, ShaperTables::Curve::softKnee},
+            {ShaperKernels::Shape::tanh, false, ShaperTables::Curve::foldback},
+            {ShaperKernels::Shape::identity, true, {}, Adaa::Function::hardClip},
+        }};
+
+        static constexpr auto trim = (SampleType)0.7;
+
+        // built by the first engine or editor, on the message thread
+        SharedResourcePointer<ShaperTables::Tables<SampleType>> tables;
+
+        AudioBuffer<SampleType> fadeBuffer, fadeRamp; // in the arena
+        SmoothedValue<SampleType> oversamplingFade{1};
+        dsp::ProcessSpec preparedSpec{44100.0, 0, 0};
+
         int currentIndexOversampling = 0;
+        int requestedIndexOversampling = 0;
+        int previousIndexOversampling = -1; // >= 0 while fading out of it
         int currentIndexWaveshaper = 0;
+        ShaperTables::Interpolation interpolation = ShaperTables::Interpolation::cubic;
+        int antialiasingOrder = 0;
+        bool preciseShaper = false;
     };
 
     ParameterReferences parameters;
     AudioProcessorValueTreeState apvts;
 
-    using Chain = dsp::ProcessorChain< //
-        dsp::Gain<float>,
-        Processor2,
-        dsp::Gain<float>
-        //
-        >;
-    Chain chain;
-
-    // We use this enum to index into the chain above
-    enum ProcessorIndices
-    {
-        inputGainIndex,
-        processor2Index,
-        outputGainIndex,
-        mixIndex
+    // Input gain, Processor2, output gain and the outer dry/wet mix for one sample type, so
+    // double precision hosts run natively instead of converting at the boundary. Both mix
+    // stages take their dry signal from the one DryPath.
+    template <typename Type>
+    struct Engine
+    {
+        using SampleType = Type;
+
+        Engine()
+        {
+            outputGain.setRampDurationSeconds(0.05);
+        }
+
+        // `linearPhase` when the linear-phase oversamplers may be used, see setOfflineHighQuality.
+        void prepare(const dsp::ProcessSpec& spec, bool linearPhase)
+        {
+            processor2.prepare(spec);
+            outputGain.prepare(spec);
+
+            // ADAA adds up to a sample more at 1x
+            const auto shaperDelay = (int)std::ceil(Adaa::getDelay(Adaa::maximumOrder));
+            dryPath.prepare(spec, OversamplerBank<SampleType>::getMaximumLatency(linearPhase) + shaperDelay);
+
+            preparedSpec = spec;
+
+            forEach([&](SmoothedValue<SampleType>& value) { value.reset(spec.sampleRate, 0.05); }, inputGain, mix);
+            processor2Fade.reset(spec.sampleRate, 0.02);
+        }
+
+        void allocate(StateArena& arena)
+        {
+            const auto numChannels = (int)preparedSpec.numChannels;
+            const auto numSamples = (int)preparedSpec.maximumBlockSize;
+
+            processor2.allocate(arena);
+            dryPath.allocate(arena);
+            arena.allocate(inputGainRamp, 1, numSamples);
+            arena.allocate(processor2Input, numChannels, numSamples);
+        }
+
+        void reset()
+        {
+            resetAll(processor2, outputGain, dryPath);
+
+            forEach(
+                [](SmoothedValue<SampleType>& value) { value.setCurrentAndTargetValue(value.getTargetValue()); },
+                inputGain,
+                mix,
+                processor2Fade
+            );
+        }
+
+        // Processor2 fades in and out over 20 ms; switching it on again starts from a clean state.
+        void setProcessor2Enabled(bool enabled)
+        {
+            if (enabled && !isProcessor2Active())
+                processor2.reset();
+
+            processor2Enabled = enabled;
+            processor2Fade.setTargetValue(enabled ? (SampleType)1 : (SampleType)0);
+        }
+
+        bool isProcessor2Active() const
+        {
+            return processor2Enabled || processor2Fade.isSmoothing();
+        }
+
+        SampleType getLatency() const
+        {
+            return isProcessor2Active() ? processor2.getLatency() : (SampleType)0;
+        }
+
+        // With Processor2 off the dry path has no delay and dry and wet are the same signal,
+        // so unity gains make the whole engine a no-op whatever the mix.
+        bool isIdentity() const
+        {
+            return !isProcessor2Active() && isUnity(inputGain) && isUnity(outputGain);
+        }
+
+        // out = mix * outputGain(Processor2(inputGain * in)) + (1 - mix) * in, where the dry
+        // `in` is delayed by the Processor2 latency. With `metering` on, the levels going
+        // into and out of Processor2 are added to inputLevels and outputLevels.
+        void process(dsp::AudioBlock<SampleType> block, bool oversamplerReady, bool metering = false)
+        {
+            // processing in place, so there is nothing to do but keep the dry path fed: once
+            // Processor2 fades back in, a mix below 100% reads the input from before
+            if (isIdentity())
+            {
+                if (metering)
+                    addLevels(block, block);
+
+                StageProfiler::measure(Stage::dryPath, [&] { dryPath.write(block, (SampleType)1); });
+                return;
+            }
+
+            const auto numSamples = (int)block.getNumSamples();
+            auto* gains = inputGainRamp.getWritePointer(0);
+
+            // an oversampling change fades the wet signal between two latencies, so the dry
+            // taps fade between them too instead of jumping
+            const auto* latencyFade = isProcessor2Active() ? processor2.beginBlock(numSamples, oversamplerReady)
+                                                           : nullptr;
+
+            const auto dry = StageProfiler::measure(
+                Stage::dryPath,
+                [&]
+                {
+                    for (auto i = 0; i < numSamples; ++i)
+                        gains[i] = inputGain.getNextValue();
+
+                    dryPath.setDelay(getLatency());
+
+                    if (latencyFade != nullptr)
+                        dryPath.setPreviousDelay(processor2.getLatency(processor2.previousIndexOversampling));
+
+                    return dryPath.process(block, gains, latencyFade);
+                }
+            );
+
+            if (!isUnity(inputGain) || !approximatelyEqual(gains[0], (SampleType)1))
+            {
+                StageProfiler::measure(
+                    Stage::inputGain,
+                    [&]
+                    {
+                        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+                            FloatVectorOperations::multiply(block.getChannelPointer(channel), gains, numSamples);
+                    }
+                );
+            }
+
+            if (metering)
+                inputLevels.add(block);
+
+            if (processor2Fade.isSmoothing())
+                processFadingProcessor2(block, dry, latencyFade);
+            else if (processor2Enabled)
+                processor2.process(block, dry, latencyFade);
+
+            if (metering)
+                outputLevels.add(block);
+
+            if (!isUnity(outputGain))
+            {
+                StageProfiler::measure(
+                    Stage::outputGain, [&] { outputGain.process(dsp::ProcessContextReplacing<SampleType>(block)); }
+                );
+            }
+
+            StageProfiler::measure(Stage::mix, [&] { mixDry(block, dry); });
+        }
+
+        // out = in + fade * (Processor2(in) - in)
+        void processFadingProcessor2(
+            dsp::AudioBlock<SampleType>& block,
+            const dsp::AudioBlock<const SampleType>& dry,
+            const SampleType* latencyFade
+        )
+        {
+            auto input = dsp::AudioBlock<SampleType>(processor2Input)
+                             .getSubsetChannelBlock(0, block.getNumChannels())
+                             .getSubBlock(0, block.getNumSamples());
+
+            input.copyFrom(block);
+            processor2.process(block, dry, latencyFade);
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                const auto fade = processor2Fade.getNextValue();
+
+                for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+                {
+                    auto* samples = block.getChannelPointer(channel);
+                    const auto old = input.getChannelPointer(channel)[i];
+                    samples[i] = old + fade * (samples[i] - old);
+                }
+            }
+        }
+
+        void addLevels(const dsp::AudioBlock<SampleType>& input, const dsp::AudioBlock<SampleType>& output)
+        {
+            inputLevels.add(input);
+            outputLevels.add(output);
+        }
+
+        template <typename Gain>
+        static bool isUnity(const Gain& gain)
+        {
+            if constexpr (std::is_same_v<Gain, dsp::Gain<SampleType>>)
+                return !gain.isSmoothing() && approximatelyEqual(gain.getGainLinear(), (SampleType)1);
+            else
+                return !gain.isSmoothing() && approximatelyEqual(gain.getTargetValue(), (SampleType)1);
+        }
+
+        void mixDry(dsp::AudioBlock<SampleType>& block, const dsp::AudioBlock<const SampleType>& dry)
+        {
+            if (!mix.isSmoothing() && mix.getTargetValue() >= (SampleType)1)
+                return;
+
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                const auto wet = mix.getNextValue();
+
+                for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+                {
+                    auto* samples = block.getChannelPointer(channel);
+                    const auto drySample = dry.getChannelPointer(channel)[i];
+                    samples[i] = drySample + wet * (samples[i] - drySample);
+                }
+            }
+        }
+
+        Processor2<SampleType> processor2;
+        dsp::Gain<SampleType> outputGain;
+        SmoothedValue<SampleType> inputGain{1}, mix{1};
+
+        bool processor2Enabled = true;
+        SmoothedValue<SampleType> processor2Fade{1};
+        AudioBuffer<SampleType> processor2Input; // in the arena
+
+        DryPath<SampleType> dryPath;
+        AudioBuffer<SampleType> inputGainRamp; // in the arena
+        dsp::ProcessSpec preparedSpec{44100.0, 0, 0};
+
+        // collected by the processor after every host block, see pushTelemetry
+        Telemetry::Accumulator inputLevels, outputLevels;
     };
 
-    std::unique_ptr<dsp::DryWetMixer<float>> mix;
+    // one per channel group, see setMaxChannelGroups; empty until prepareToPlay and for the
+    // precision not in use
+    template <typename SampleType>
+    using Engines = std::vector<std::unique_ptr<Engine<SampleType>>>;
+
+    Engines<float> floatEngines;
+    Engines<double> doubleEngines;
+    std::unique_ptr<WorkerPool> workers;
+
+    // only active in offline renders, see setOfflineBlockSize
+    BlockAccumulator<float> floatAccumulator;
+    BlockAccumulator<double> doubleAccumulator;
+
+    // the buffers and filter states of the engines and accumulators, see prepareToPlay
+    StateArena stateArena;
+    bool highQualityRendering = false; // set by prepareToPlay
 
     //==============================================================================
-    std::atomic<bool> requiresUpdate{true};
+    // bit n is set when the parameter with index n changed since the last block
+    static constexpr uint32 allParameters = ~(uint32)0;
+    std::atomic<uint32> dirtyParameters{allParameters};
+
+    std::atomic<int> latencySamples{0}; // what the audio thread runs at, reported asynchronously
+
+    Telemetry::Fifo telemetry;
+    std::atomic<bool> telemetryEnabled{false};
+
+   #if MY_STAGE_PROFILING
+    StageProfiler::Histograms stageHistograms;
+   #endif
+
+    int64 samplePosition = 0;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginProcessor)
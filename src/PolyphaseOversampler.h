@@ -0,0 +1,522 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "StateArena.h"
+
+//==============================================================================
+// Half-band polyphase oversampling with filter designs shared across the process.
+//
+// dsp::Oversampling designs its filters in its constructor, so every plugin instance paid
+// for the designs of the factors it built and kept its own copy of the coefficients. Here
+// each 2x stage is designed once, with the same dsp::FilterDesign calls and parameters as
+// dsp::Oversampling at maximum quality, into an immutable StageDesign that a process-wide
+// DesignCache hands out by reference count; it is freed with the last oversampler using it.
+// An Oversampler itself only owns the filter states of its channels and the oversampled
+// buffers, together in one StateArena.
+//
+// The half-band designs are normalised to the sample rate, so they don't depend on it: a
+// stage is keyed by its filter type and position alone, and the first stage of 2x, 4x and
+// 8x is the same design.
+namespace Polyphase
+{
+enum class FilterType
+{
+    halfBandFIREquiripple,
+    halfBandIIR
+};
+
+//==============================================================================
+// One phase of a polyphase filter: output[n] = sum_j coefficients[j] * input[n - delay - j],
+// where IIR designs only keep the chain of allpass coefficients.
+template <typename SampleType>
+struct Branch
+{
+    int delay = 0;
+    std::vector<SampleType> coefficients;
+
+    int getLength() const noexcept
+    {
+        return delay + (int)coefficients.size();
+    }
+};
+
+// The filters of one 2x stage. For upsampling, branch p computes the output samples 2n + p
+// from the input; for downsampling, it filters the input samples 2n + p, and the branches
+// are summed.
+template <typename SampleType>
+class StageDesign
+{
+  public:
+    StageDesign(FilterType type, size_t stageIndex)
+        : filterType(type)
+    {
+        // dsp::Oversampling's maximum quality settings
+        const auto n = (SampleType)stageIndex;
+        const auto widthScale = (SampleType)(stageIndex == 0 ? 0.5 : 1.0);
+        const auto widthUp = (SampleType)0.1 * widthScale;
+        const auto widthDown = (SampleType)0.12 * widthScale;
+        const auto stopbandDown = (SampleType)-70 + 10 * n;
+
+        if (filterType == FilterType::halfBandIIR)
+        {
+            designIIR(up, (SampleType)-75 + 10 * n, widthUp, 0);
+            designIIR(down, stopbandDown, widthDown, 1);
+        }
+        else
+        {
+            designFIR(up, (SampleType)-90 + 10 * n, widthUp, 2, 0);
+            designFIR(down, stopbandDown, widthDown, 1, 1);
+        }
+    }
+
+    // In samples at the stage's oversampled rate, up and down together.
+    double getLatency() const noexcept
+    {
+        return latency;
+    }
+
+    const FilterType filterType;
+    std::array<Branch<SampleType>, 2> up, down;
+
+  private:
+    // The direct path's allpass sections, and the delayed path's after its one sample delay,
+    // which is left to the branch delay. Both are first order sections in z^2; the latency is
+    // the mean of the two paths' group delays at DC.
+    void designIIR(std::array<Branch<SampleType>, 2>& branches, SampleType stopband, SampleType width, int delay)
+    {
+        const auto structure = dsp::FilterDesign<SampleType>::designIIRLowpassHalfBandPolyphaseAllpassMethod(
+            width, stopband
+        );
+
+        auto pathDelay = 1.0;
+
+        const auto addSections = [&](const auto& path, Branch<SampleType>& branch)
+        {
+            for (auto i = 0; i < path.size(); ++i)
+            {
+                if (path[i]->coefficients.size() != 5)
+                    continue;
+
+                const auto alpha = path[i]->coefficients[0];
+                branch.coefficients.push_back(alpha);
+                pathDelay += 2.0 * (1.0 - alpha) / (1.0 + alpha);
+            }
+        };
+
+        addSections(structure.directPath, branches[0]);
+        addSections(structure.delayedPath, branches[1]);
+        branches[1].delay = delay;
+
+        latency += 0.5 * pathDelay;
+    }
+
+    // The taps of each phase times `gain`, without the zeros at either end, so the half-band
+    // phase that is only the centre tap is a plain delay. The latency is half the order.
+    void designFIR(
+        std::array<Branch<SampleType>, 2>& branches, SampleType stopband, SampleType width, int gain, int delay
+    )
+    {
+        const auto coefficients =
+            dsp::FilterDesign<SampleType>::designFIRLowpassHalfBandEquirippleMethod(width, stopband);
+        const auto* taps = coefficients->getRawCoefficients();
+        const auto numTaps = (int)coefficients->getFilterOrder() + 1;
+
+        for (auto phase = 0; phase < 2; ++phase)
+        {
+            auto& branch = branches[(size_t)phase];
+            branch.delay = phase * delay;
+
+            for (auto k = phase; k < numTaps; k += 2)
+                branch.coefficients.push_back(taps[k] * (SampleType)gain);
+
+            while (!branch.coefficients.empty() && branch.coefficients.back() == 0)
+                branch.coefficients.pop_back();
+
+            while (!branch.coefficients.empty() && branch.coefficients.front() == 0)
+            {
+                branch.coefficients.erase(branch.coefficients.begin());
+                ++branch.delay;
+            }
+        }
+
+        latency += 0.5 * (numTaps - 1);
+    }
+
+    double latency = 0;
+};
+
+//==============================================================================
+// Every stage design in use in the process, by filter type and position. Hold a
+// SharedResourcePointer<DesignCache> so the entries outlive a single lookup. Message thread
+// and the oversampler preparation thread.
+template <typename SampleType>
+class DesignCache
+{
+  public:
+    using Design = std::shared_ptr<const StageDesign<SampleType>>;
+
+    Design get(FilterType filterType, size_t stageIndex)
+    {
+        const ScopedLock lock(mutex);
+
+        auto& entry = entries[{filterType, stageIndex}];
+        auto design = entry.lock();
+
+        if (design == nullptr)
+        {
+            design = std::make_shared<const StageDesign<SampleType>>(filterType, stageIndex);
+            entry = design;
+            ++numDesigned;
+        }
+
+        return design;
+    }
+
+    // How many designs were made since the cache was created, for the benchmarks.
+    int getNumDesigned() const
+    {
+        const ScopedLock lock(mutex);
+        return numDesigned;
+    }
+
+  private:
+    CriticalSection mutex;
+    std::map<std::pair<FilterType, size_t>, std::weak_ptr<const StageDesign<SampleType>>> entries;
+    int numDesigned = 0;
+};
+
+//==============================================================================
+// The dsp::Oversampling interface Processor2 uses, on shared designs.
+template <typename SampleType>
+class Oversampler
+{
+  public:
+    Oversampler(size_t numChannelsIn, size_t numStages, FilterType filterType, bool useIntegerLatency)
+        : numChannels(jmax((size_t)1, numChannelsIn))
+        , integerLatency(useIntegerLatency)
+    {
+        for (size_t i = 0; i < numStages; ++i)
+        {
+            stages.emplace_back(designs->get(filterType, i));
+            uncompensatedLatency += stages.back().design->getLatency() / (double)(2 << i);
+        }
+
+        if (integerLatency)
+        {
+            // as dsp::Oversampling: pad to the next whole sample, by at least 0.618 of one, as
+            // the Thiran allpass is poor for short fractional delays
+            fractionalDelay = 1.0 - (uncompensatedLatency - std::floor(uncompensatedLatency));
+
+            if (approximatelyEqual(fractionalDelay, 1.0))
+                fractionalDelay = 0.0;
+            else if (fractionalDelay < 0.618)
+                fractionalDelay += 1.0;
+        }
+    }
+
+    size_t getOversamplingFactor() const noexcept
+    {
+        return (size_t)1 << stages.size();
+    }
+
+    // At the base rate.
+    SampleType getLatencyInSamples() const noexcept
+    {
+        return (SampleType)(uncompensatedLatency + fractionalDelay);
+    }
+
+    // Allocates the states and buffers. Message or preparation thread.
+    void initProcessing(size_t maximumBlockSize)
+    {
+        maximumNumSamples = maximumBlockSize;
+
+        for (size_t i = 0; i < stages.size(); ++i)
+            stages[i].prepare(numChannels, maximumBlockSize << (i + 1));
+
+        arena.build(
+            [this](StateArena& stateArena)
+            {
+                for (auto& stage : stages)
+                    stage.allocate(stateArena);
+
+                if (stages.empty())
+                    stateArena.allocate(bypassBuffer, (int)numChannels, (int)maximumNumSamples);
+            }
+        );
+
+        if (integerLatency)
+        {
+            delayLine.setMaximumDelayInSamples(2);
+            delayLine.prepare({0.0, (uint32)maximumBlockSize, (uint32)numChannels}); // rate unused
+            delayLine.setDelay((SampleType)fractionalDelay);
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& stage : stages)
+            stage.reset();
+
+        if (integerLatency)
+            delayLine.reset();
+    }
+
+    // Returns the block upsampled into the last stage's buffer.
+    dsp::AudioBlock<SampleType> processSamplesUp(const dsp::AudioBlock<const SampleType>& input)
+    {
+        jassert(input.getNumChannels() <= numChannels && input.getNumSamples() <= maximumNumSamples);
+
+        const auto numInputChannels = input.getNumChannels();
+        const auto numSamples = input.getNumSamples();
+
+        if (stages.empty())
+        {
+            dsp::AudioBlock<SampleType> block(bypassBuffer);
+            block = block.getSubsetChannelBlock(0, numInputChannels).getSubBlock(0, numSamples);
+            block.copyFrom(input);
+            return block;
+        }
+
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            auto& stage = stages[i];
+
+            for (size_t channel = 0; channel < numInputChannels; ++channel)
+            {
+                const auto* source = i == 0 ? input.getChannelPointer(channel)
+                                            : stages[i - 1].buffer.getReadPointer((int)channel);
+                stage.processUp(channel, source, (numSamples << i));
+            }
+        }
+
+        return dsp::AudioBlock<SampleType>(stages.back().buffer)
+            .getSubsetChannelBlock(0, numInputChannels)
+            .getSubBlock(0, numSamples << stages.size());
+    }
+
+    // Downsamples what processSamplesUp returned into `output`.
+    void processSamplesDown(dsp::AudioBlock<SampleType>& output)
+    {
+        const auto numOutputChannels = output.getNumChannels();
+        const auto numSamples = output.getNumSamples();
+
+        if (stages.empty())
+        {
+            output.copyFrom(dsp::AudioBlock<SampleType>(bypassBuffer).getSubBlock(0, numSamples));
+            return;
+        }
+
+        for (auto i = stages.size(); i-- > 0;)
+        {
+            auto& stage = stages[i];
+
+            for (size_t channel = 0; channel < numOutputChannels; ++channel)
+            {
+                auto* destination = i == 0 ? output.getChannelPointer(channel)
+                                           : stages[i - 1].buffer.getWritePointer((int)channel);
+                stage.processDown(channel, destination, (numSamples << i));
+            }
+        }
+
+        if (integerLatency)
+        {
+            for (size_t channel = 0; channel < numOutputChannels; ++channel)
+            {
+                auto* data = output.getChannelPointer(channel);
+
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    delayLine.pushSample((int)channel, data[i]);
+                    data[i] = delayLine.popSample((int)channel);
+                }
+            }
+        }
+    }
+
+  private:
+    //==============================================================================
+    // A 2x stage: the shared design, and per channel its filter states and oversampled audio.
+    struct Stage
+    {
+        explicit Stage(typename DesignCache<SampleType>::Design designIn)
+            : design(std::move(designIn))
+        {
+        }
+
+        typename DesignCache<SampleType>::Design design;
+
+        AudioBuffer<SampleType> buffer; // in the oversampler's arena
+
+        // IIR: the allpass states, up then down, and the delayed path's last output down.
+        // FIR: a history of the input up and of each input phase down, each stored twice over
+        // so every branch reads its taps contiguously.
+        SampleType* states = nullptr;
+        int* positions = nullptr;
+        size_t numChannels = 0, maximumNumSamples = 0, stride = 0, historyLength = 0;
+
+        bool isIIR() const noexcept
+        {
+            return design->filterType == FilterType::halfBandIIR;
+        }
+
+        // Followed by allocate().
+        void prepare(size_t numChannelsIn, size_t maximumNumSamplesIn)
+        {
+            numChannels = numChannelsIn;
+            maximumNumSamples = maximumNumSamplesIn;
+            historyLength = 0;
+
+            if (isIIR())
+            {
+                stride = design->up[0].coefficients.size() + design->up[1].coefficients.size()
+                       + design->down[0].coefficients.size() + design->down[1].coefficients.size() + 1;
+            }
+            else
+            {
+                for (const auto* branches : {&design->up, &design->down})
+                    for (const auto& branch : *branches)
+                        historyLength = jmax(historyLength, (size_t)branch.getLength());
+
+                stride = 3 * 2 * historyLength;
+            }
+
+        }
+
+        void allocate(StateArena& stateArena)
+        {
+            stateArena.allocate(buffer, (int)numChannels, (int)maximumNumSamples);
+            states = stateArena.allocate<SampleType>(numChannels * stride);
+            positions = stateArena.allocate<int>(numChannels * 2);
+        }
+
+        void reset()
+        {
+            std::fill(states, states + numChannels * stride, (SampleType)0);
+            std::fill(positions, positions + numChannels * 2, 0);
+        }
+
+        // `numSamples` base rate samples from `source` into the buffer.
+        void processUp(size_t channel, const SampleType* source, size_t numSamples)
+        {
+            auto* destination = buffer.getWritePointer((int)channel);
+            auto* state = states + channel * stride;
+
+            if (isIIR())
+            {
+                auto* directState = state;
+                auto* delayedState = directState + design->up[0].coefficients.size();
+
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    destination[i << 1] = processAllpasses(design->up[0].coefficients, directState, source[i]);
+                    destination[(i << 1) + 1] = processAllpasses(design->up[1].coefficients, delayedState, source[i]);
+                }
+
+                return;
+            }
+
+            auto& position = positions[channel * 2];
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto* history = push(state, advance(position), source[i]);
+
+                for (size_t phase = 0; phase < 2; ++phase)
+                    destination[(i << 1) + phase] = convolve(design->up[phase], history);
+            }
+        }
+
+        // The buffer's first 2 * `numSamples` samples, down into `destination`.
+        void processDown(size_t channel, SampleType* destination, size_t numSamples)
+        {
+            const auto* source = buffer.getReadPointer((int)channel);
+            auto* state = states + channel * stride;
+
+            if (isIIR())
+            {
+                const auto& up = design->up;
+                auto* directState = state + up[0].coefficients.size() + up[1].coefficients.size();
+                auto* delayedState = directState + design->down[0].coefficients.size();
+                auto& delayed = delayedState[design->down[1].coefficients.size()];
+
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    const auto direct = processAllpasses(design->down[0].coefficients, directState, source[i << 1]);
+                    destination[i] = (delayed + direct) * (SampleType)0.5;
+                    delayed = processAllpasses(design->down[1].coefficients, delayedState, source[(i << 1) + 1]);
+                }
+
+                return;
+            }
+
+            auto* evenState = state + 2 * historyLength;
+            auto* oddState = evenState + 2 * historyLength;
+            auto& position = positions[channel * 2 + 1];
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                advance(position);
+                const auto* even = push(evenState, position, source[i << 1]);
+                const auto* odd = push(oddState, position, source[(i << 1) + 1]);
+
+                destination[i] = convolve(design->down[0], even) + convolve(design->down[1], odd);
+            }
+        }
+
+        // A chain of first order allpass sections, transposed direct form II.
+        static SampleType processAllpasses(const std::vector<SampleType>& alphas, SampleType* state, SampleType x)
+        {
+            for (size_t n = 0; n < alphas.size(); ++n)
+            {
+                const auto y = alphas[n] * x + state[n];
+                state[n] = x - alphas[n] * y;
+                x = y;
+            }
+
+            return x;
+        }
+
+        // The histories run backwards, so the newest sample comes first.
+        int advance(int& position) const noexcept
+        {
+            position = (position == 0 ? (int)historyLength : position) - 1;
+            return position;
+        }
+
+        // Writes x at `position` and returns the history from there.
+        const SampleType* push(SampleType* history, int position, SampleType x) const noexcept
+        {
+            history[position] = history[(size_t)position + historyLength] = x;
+            return history + position;
+        }
+
+        static SampleType convolve(const Branch<SampleType>& branch, const SampleType* history)
+        {
+            const auto* input = history + branch.delay;
+            auto sum = (SampleType)0;
+
+            for (size_t j = 0; j < branch.coefficients.size(); ++j)
+                sum += branch.coefficients[j] * input[j];
+
+            return sum;
+        }
+    };
+
+    SharedResourcePointer<DesignCache<SampleType>> designs;
+    std::vector<Stage> stages;
+
+    size_t numChannels;
+    size_t maximumNumSamples = 0;
+    bool integerLatency;
+    double uncompensatedLatency = 0, fractionalDelay = 0;
+
+    AudioBuffer<SampleType> bypassBuffer; // the copy 1x shapes in place
+    StateArena arena;
+    dsp::DelayLine<SampleType, dsp::DelayLineInterpolationTypes::Thiran> delayLine;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Oversampler)
+};
+} // namespace Polyphase
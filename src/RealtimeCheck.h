@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Marks code that must never allocate, free or lock, i.e. everything processBlock runs,
+// on whichever thread runs it.
+//
+// Compiles to nothing unless MY_REALTIME_CHECKS is defined, which only the rtcheck tool
+// does: it supplies these functions and traps allocations and mutex locks made by a
+// thread while it is inside a scope, see tools/rtcheck.
+#if MY_REALTIME_CHECKS
+namespace RealtimeCheck
+{
+void enterScope() noexcept;
+void exitScope() noexcept;
+
+// Waives the checks for one deliberate, bounded call, e.g. waking a background thread.
+void enterExemption() noexcept;
+void exitExemption() noexcept;
+
+// Loads what the checker needs for reporting, so that doesn't count against a scope.
+void install();
+
+// Prints every distinct offending call stack, returns how many there were.
+int printViolations(std::ostream&);
+
+struct ScopedRealtime
+{
+    ScopedRealtime() noexcept
+    {
+        enterScope();
+    }
+
+    ~ScopedRealtime() noexcept
+    {
+        exitScope();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+};
+
+struct ScopedExemption
+{
+    ScopedExemption() noexcept
+    {
+        enterExemption();
+    }
+
+    ~ScopedExemption() noexcept
+    {
+        exitExemption();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedExemption)
+};
+} // namespace RealtimeCheck
+
+ #define MY_REALTIME_SCOPE const RealtimeCheck::ScopedRealtime realtimeScope
+ #define MY_REALTIME_EXEMPTION const RealtimeCheck::ScopedExemption realtimeExemption
+#else
+ #define MY_REALTIME_SCOPE
+ #define MY_REALTIME_EXEMPTION
+#endif
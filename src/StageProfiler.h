@@ -0,0 +1,239 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if MY_STAGE_PROFILING
+ #include <bit>
+
+ #if JUCE_INTEL
+  #if JUCE_MSVC
+   #include <intrin.h>
+  #else
+   #include <x86intrin.h>
+  #endif
+ #endif
+#endif
+
+//==============================================================================
+// Per-stage timing of the audio path, compiled in with -DMY_STAGE_PROFILING=ON.
+//
+// measure() wraps one stage. With profiling on it reads the CPU's cycle counter (the TSC
+// on x86, the virtual counter on arm64) around the call and adds the count to a log2
+// histogram of the instance processing on this thread; without it, it is just the call.
+// The histograms are atomics, so channel groups on worker threads record concurrently
+// and the editor reads them at any time, without locks.
+namespace StageProfiler
+{
+enum class Stage
+{
+    inputGain, // applying the ramp
+    dryPath,   // computing the input gain ramp it carries, and the delay
+    distGain,
+    highpass,
+    upsample,
+    waveshaper, // shape, clip and trim, fused in one kernel
+    downsample,
+    lowpass,
+    compGain,
+    processor2Mix,
+    outputGain,
+    mix,
+    count
+};
+
+constexpr std::array<const char*, (size_t)Stage::count> stageNames{
+    "inputGain",
+    "dryPath",
+    "distGain",
+    "highpass",
+    "upsample",
+    "waveshaper",
+    "downsample",
+    "lowpass",
+    "compGain",
+    "processor2Mix",
+    "outputGain",
+    "mix",
+};
+
+#if MY_STAGE_PROFILING
+//==============================================================================
+inline uint64 getCycles() noexcept
+{
+   #if JUCE_INTEL
+    return (uint64)__rdtsc();
+   #elif JUCE_ARM && JUCE_64BIT && !JUCE_MSVC
+    uint64 counter;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(counter));
+    return counter;
+   #else
+    return (uint64)Time::getHighResolutionTicks();
+   #endif
+}
+
+class Histograms
+{
+  public:
+    // bucket b counts calls that took [2^(b-1), 2^b) cycles
+    static constexpr int numBuckets = 40;
+
+    struct Summary
+    {
+        uint64 calls = 0;
+        double meanCycles = 0.0;
+        uint64 p50Cycles = 0, p99Cycles = 0; // upper bucket bounds
+        double share = 0.0;                  // of the cycles of all stages
+    };
+
+    // Any thread.
+    void record(Stage stage, uint64 cycles) noexcept
+    {
+        auto& data = stages[(size_t)stage];
+        const auto bucket = jmin(numBuckets - 1, (int)std::bit_width(cycles));
+
+        data.buckets[(size_t)bucket].fetch_add(1, std::memory_order_relaxed);
+        data.calls.fetch_add(1, std::memory_order_relaxed);
+        data.cycles.fetch_add(cycles, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& data : stages)
+        {
+            for (auto& bucket : data.buckets)
+                bucket.store(0, std::memory_order_relaxed);
+
+            data.calls.store(0, std::memory_order_relaxed);
+            data.cycles.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<Summary, (size_t)Stage::count> getSummaries() const
+    {
+        std::array<Summary, (size_t)Stage::count> summaries;
+        auto totalCycles = 0.0;
+
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            const auto& data = stages[i];
+            auto& summary = summaries[i];
+
+            summary.calls = data.calls.load(std::memory_order_relaxed);
+            const auto cycles = (double)data.cycles.load(std::memory_order_relaxed);
+            summary.meanCycles = summary.calls > 0 ? cycles / (double)summary.calls : 0.0;
+            summary.p50Cycles = getPercentile(data, 0.5);
+            summary.p99Cycles = getPercentile(data, 0.99);
+            summary.share = cycles;
+            totalCycles += cycles;
+        }
+
+        for (auto& summary : summaries)
+            summary.share = totalCycles > 0.0 ? summary.share / totalCycles : 0.0;
+
+        return summaries;
+    }
+
+    // One line per stage: summary figures, then the non-empty buckets as bound:count.
+    String toText() const
+    {
+        String text = "stage\tcalls\tmeanCycles\tp50\tp99\tshare\tbuckets\n";
+        const auto summaries = getSummaries();
+
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            const auto& summary = summaries[i];
+            text << stageNames[i] << "\t" << String((int64)summary.calls) << "\t" << String(summary.meanCycles, 1)
+                 << "\t" << String((int64)summary.p50Cycles) << "\t" << String((int64)summary.p99Cycles) << "\t"
+                 << String(summary.share * 100.0, 1) << "%\t";
+
+            for (size_t bucket = 0; bucket < (size_t)numBuckets; ++bucket)
+                if (const auto count = stages[i].buckets[bucket].load(std::memory_order_relaxed); count > 0)
+                    text << String((int64)1 << bucket) << ":" << String((int64)count) << " ";
+
+            text << "\n";
+        }
+
+        return text;
+    }
+
+    bool writeTo(const File& file) const
+    {
+        return file.replaceWithText(toText());
+    }
+
+  private:
+    struct StageData
+    {
+        std::array<std::atomic<uint64>, numBuckets> buckets{};
+        std::atomic<uint64> calls{0};
+        std::atomic<uint64> cycles{0};
+    };
+
+    static uint64 getPercentile(const StageData& data, double percentile)
+    {
+        const auto calls = data.calls.load(std::memory_order_relaxed);
+        auto seen = (uint64)0;
+
+        for (size_t bucket = 0; bucket < (size_t)numBuckets; ++bucket)
+        {
+            seen += data.buckets[bucket].load(std::memory_order_relaxed);
+
+            if (calls > 0 && (double)seen >= percentile * (double)calls)
+                return (uint64)1 << bucket;
+        }
+
+        return 0;
+    }
+
+    std::array<StageData, (size_t)Stage::count> stages;
+};
+
+// the instance processing on this thread, see ScopedInstance
+inline thread_local Histograms* currentHistograms = nullptr;
+
+// Routes measure() on this thread to `histograms` for its lifetime.
+struct ScopedInstance
+{
+    explicit ScopedInstance(Histograms& histograms) noexcept
+        : previous(std::exchange(currentHistograms, &histograms))
+    {
+    }
+
+    ~ScopedInstance() noexcept
+    {
+        currentHistograms = previous;
+    }
+
+    Histograms* const previous;
+};
+#endif
+
+//==============================================================================
+template <typename Func>
+decltype(auto) measure([[maybe_unused]] Stage stage, Func&& func)
+{
+   #if MY_STAGE_PROFILING
+    struct ScopedStage
+    {
+        ~ScopedStage()
+        {
+            if (currentHistograms != nullptr)
+                currentHistograms->record(stage, getCycles() - start);
+        }
+
+        const Stage stage;
+        const uint64 start = getCycles();
+    };
+
+    const ScopedStage scopedStage{stage};
+   #endif
+
+    return func();
+}
+} // namespace StageProfiler
+
+#if MY_STAGE_PROFILING
+ #define MY_PROFILE_INSTANCE(histograms) const StageProfiler::ScopedInstance profileInstance(histograms)
+#else
+ #define MY_PROFILE_INSTANCE(histograms)
+#endif
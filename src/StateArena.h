@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// One contiguous, cache-line aligned block of memory for the DSP state of a whole chain,
+// sized at prepare time, so the state sits together in memory and processing never touches
+// the heap.
+//
+// Components lay themselves out in an allocate(StateArena&) method, which build() runs
+// twice: first to add up the sizes, then on the block to hand out the spans. Every span
+// starts on a cache line, so channel groups processed on different threads never share
+// one. The block is zeroed by every build and kept across builds that fit in it, so
+// preparing again for a smaller block size or sample rate doesn't allocate.
+class StateArena
+{
+  public:
+    static constexpr size_t alignment = 64;
+
+    // Message thread. Runs `layout(arena)` to measure it, then again to place it.
+    template <typename Layout>
+    void build(Layout&& layout)
+    {
+        block = nullptr;
+        used = 0;
+        layout(*this);
+
+        const auto required = used;
+
+        if (required > capacity)
+        {
+            storage = std::make_unique<std::byte[]>(required + alignment - 1);
+            capacity = required;
+        }
+
+        const auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        block = storage.get() + ((alignment - address % alignment) % alignment);
+        std::fill(block, block + required, std::byte{});
+
+        used = 0;
+        layout(*this);
+        jassert(used == required);
+    }
+
+    // A zeroed span of `count` objects; nullptr while measuring.
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+        auto* span = block != nullptr ? reinterpret_cast<T*>(block + used) : nullptr;
+        used += (count * sizeof(T) + alignment - 1) / alignment * alignment;
+        return span;
+    }
+
+    // Points `buffer` at one span per channel.
+    template <typename SampleType>
+    void allocate(AudioBuffer<SampleType>& buffer, int numChannels, int numSamples)
+    {
+        std::vector<SampleType*> channels((size_t)numChannels);
+
+        for (auto& channel : channels)
+            channel = allocate<SampleType>((size_t)numSamples);
+
+        if (block == nullptr)
+            return;
+
+        if (numChannels > 0 && numSamples > 0)
+            buffer.setDataToReferTo(channels.data(), numChannels, numSamples);
+        else
+            buffer = AudioBuffer<SampleType>();
+    }
+
+    // Bytes in use since the last build.
+    size_t getSize() const noexcept
+    {
+        return used;
+    }
+
+  private:
+    std::unique_ptr<std::byte[]> storage;
+    std::byte* block = nullptr; // aligned start of storage, nullptr while measuring
+    size_t capacity = 0, used = 0;
+};
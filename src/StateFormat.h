@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// The plugin state as written by getStateInformation, little-endian:
+//
+//   uint32  magic 'MPST'
+//   uint16  version
+//   uint16  number of entries
+//   entries of { uint32 FNV-1a hash of the parameter ID, float32 plain (unnormalised) value }
+//
+// Values are stored unnormalised so a later change of a parameter's range keeps its
+// setting. Readers skip unknown IDs; anything without the magic is a legacy XML blob.
+namespace StateFormat
+{
+constexpr uint32 magic = ByteOrder::makeInt('M', 'P', 'S', 'T');
+constexpr int version = 1;
+
+struct Entry
+{
+    uint32 id;
+    float value;
+};
+
+inline uint32 hashParameterId(const String& parameterId)
+{
+    auto hash = (uint32)2166136261;
+
+    for (auto* c = parameterId.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (uint8)*c) * (uint32)16777619;
+
+    return hash;
+}
+
+inline void write(MemoryBlock& destData, const std::vector<Entry>& entries)
+{
+    MemoryOutputStream stream(destData, false);
+
+    stream.writeInt((int)magic);
+    stream.writeShort((short)version);
+    stream.writeShort((short)entries.size());
+
+    for (const auto& entry : entries)
+    {
+        stream.writeInt((int)entry.id);
+        stream.writeFloat(entry.value);
+    }
+}
+
+// Returns nothing if the data is not in this format or comes from a newer version.
+inline std::optional<std::vector<Entry>> read(const void* data, int sizeInBytes)
+{
+    constexpr auto headerSize = 8;
+    constexpr auto entrySize = 8;
+
+    if (data == nullptr || sizeInBytes < headerSize)
+        return {};
+
+    MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+
+    if ((uint32)stream.readInt() != magic)
+        return {};
+
+    if ((int)(uint16)stream.readShort() > version)
+    {
+        jassertfalse; // saved by a newer build
+        return {};
+    }
+
+    const auto numEntries = (int)(uint16)stream.readShort();
+
+    if (stream.getNumBytesRemaining() < (int64)numEntries * entrySize)
+        return {};
+
+    std::vector<Entry> entries((size_t)numEntries);
+
+    for (auto& entry : entries)
+    {
+        entry.id = (uint32)stream.readInt();
+        entry.value = stream.readFloat();
+    }
+
+    return entries;
+}
+} // namespace StateFormat
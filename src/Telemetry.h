@@ -0,0 +1,120 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Level telemetry from the audio thread to the editor.
+//
+// The engines measure peak, RMS and clipped samples going into and coming out of
+// Processor2; the processor pushes one Frame per host block into a single-producer,
+// single-consumer FIFO that the editor drains on a timer. Nothing locks or allocates,
+// metering costs one pass over the block per tap point, and nothing while it is off.
+namespace Telemetry
+{
+struct Levels
+{
+    float peak = 0.0f; // linear
+    float rms = 0.0f;  // linear, over all channels
+    int clippedSamples = 0;
+};
+
+struct Frame
+{
+    Levels input;  // into Processor2, after the input gain
+    Levels output; // out of Processor2, before the output gain and mix
+    int numSamples = 0;
+};
+
+//==============================================================================
+// Running sums at one tap point of one engine, over the sub-blocks of a host block.
+class Accumulator
+{
+  public:
+    template <typename SampleType>
+    void add(const dsp::AudioBlock<SampleType>& block)
+    {
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            const auto* samples = block.getChannelPointer(channel);
+            auto channelPeak = (SampleType)0, channelSum = (SampleType)0;
+            auto channelClipped = 0;
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                const auto magnitude = std::abs(samples[i]);
+                channelPeak = jmax(channelPeak, magnitude);
+                channelSum += magnitude * magnitude;
+                channelClipped += magnitude > (SampleType)1 ? 1 : 0;
+            }
+
+            peak = jmax(peak, (float)channelPeak);
+            sumOfSquares += (double)channelSum;
+            clippedSamples += channelClipped;
+        }
+
+        numValues += (int64)(numSamples * block.getNumChannels());
+    }
+
+    // Adds levels already reduced over `count` values, e.g. to combine several frames.
+    void add(const Levels& levels, int64 count)
+    {
+        peak = jmax(peak, levels.peak);
+        sumOfSquares += (double)levels.rms * (double)levels.rms * (double)count;
+        clippedSamples += levels.clippedSamples;
+        numValues += count;
+    }
+
+    void merge(const Accumulator& other)
+    {
+        peak = jmax(peak, other.peak);
+        sumOfSquares += other.sumOfSquares;
+        clippedSamples += other.clippedSamples;
+        numValues += other.numValues;
+    }
+
+    Levels getLevels() const
+    {
+        const auto rms = numValues > 0 ? std::sqrt(sumOfSquares / (double)numValues) : 0.0;
+        return {peak, (float)rms, clippedSamples};
+    }
+
+    void clear()
+    {
+        *this = {};
+    }
+
+  private:
+    float peak = 0.0f;
+    double sumOfSquares = 0.0;
+    int clippedSamples = 0;
+    int64 numValues = 0;
+};
+
+//==============================================================================
+class Fifo
+{
+  public:
+    // Audio thread. The frame is dropped while the reader is behind, e.g. with the editor
+    // hidden, so the writer never waits.
+    void push(const Frame& frame) noexcept
+    {
+        fifo.write(1).forEach([&](int index) { frames[(size_t)index] = frame; });
+    }
+
+    // Reader thread. Calls func(frame) for every waiting frame, oldest first.
+    template <typename Func>
+    void popAll(Func&& func)
+    {
+        fifo.read(fifo.getNumReady()).forEach([&](int index) { func(frames[(size_t)index]); });
+    }
+
+  private:
+    // a few hundred milliseconds of small blocks between two editor frames
+    static constexpr int capacity = 128;
+
+    AbstractFifo fifo{capacity};
+    std::array<Frame, capacity> frames{};
+};
+} // namespace Telemetry
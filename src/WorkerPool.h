@@ -0,0 +1,124 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// A few real-time threads that run the jobs of one batch alongside the calling thread.
+//
+// run() hands job i to worker i - 1 through that worker's ticket, does job 0 itself and
+// then waits for the others on a countdown. Nothing allocates or takes a lock; idle
+// workers spin briefly and then sleep in std::atomic::wait.
+//
+// Workers fall back to ordinary high priority threads where real-time ones are refused,
+// e.g. on Linux without rtprio, and are left out if neither starts; jobs without a worker
+// then run on the calling thread after job 0.
+class WorkerPool
+{
+  public:
+    explicit WorkerPool(int numWorkers)
+    {
+        for (auto i = 0; i < numWorkers; ++i)
+        {
+            auto worker = std::make_unique<Worker>(*this, getNumWorkers() + 1);
+
+            if (worker->startRealtimeThread(Thread::RealtimeOptions{}.withPriority(10))
+                || worker->startThread(Thread::Priority::highest))
+                workers.push_back(std::move(worker));
+        }
+    }
+
+    ~WorkerPool()
+    {
+        for (auto& worker : workers)
+        {
+            worker->signalThreadShouldExit();
+            worker->ticket.fetch_add(1, std::memory_order_release);
+            worker->ticket.notify_one();
+            worker->stopThread(1000);
+        }
+    }
+
+    int getNumWorkers() const
+    {
+        return (int)workers.size();
+    }
+
+    // Calls func(i) for i in [0, numJobs) and returns once all of them are done.
+    template <typename Func>
+    void run(int numJobs, Func& func)
+    {
+        const auto numThreaded = jmin(numJobs - 1, getNumWorkers());
+
+        job = [](void* context, int index) { (*static_cast<Func*>(context))(index); };
+        jobContext = &func;
+        pending.store(numThreaded, std::memory_order_relaxed);
+
+        for (auto i = 0; i < numThreaded; ++i)
+        {
+            workers[(size_t)i]->ticket.fetch_add(1, std::memory_order_release);
+            workers[(size_t)i]->ticket.notify_one();
+        }
+
+        func(0);
+
+        for (auto i = numThreaded + 1; i < numJobs; ++i)
+            func(i);
+
+        for (auto remaining = pending.load(std::memory_order_acquire); remaining != 0;
+             remaining = pending.load(std::memory_order_acquire))
+            waitForChange(pending, remaining);
+    }
+
+  private:
+    struct Worker final : public Thread
+    {
+        Worker(WorkerPool& ownerIn, int indexIn)
+            : Thread("Channel group " + String(indexIn))
+            , owner(ownerIn)
+            , index(indexIn)
+        {
+        }
+
+        void run() override
+        {
+            // starts from the initial ticket, the first job may be handed out before this runs
+            for (uint32 seen = 0;;)
+            {
+                waitForChange(ticket, seen);
+                seen = ticket.load(std::memory_order_acquire);
+
+                if (threadShouldExit())
+                    return;
+
+                owner.job(owner.jobContext, index);
+
+                owner.pending.fetch_sub(1, std::memory_order_acq_rel);
+                owner.pending.notify_one();
+            }
+        }
+
+        WorkerPool& owner;
+        const int index;
+        std::atomic<uint32> ticket{0};
+    };
+
+    // Returns once value differs from old: spins first, as the next block or the last
+    // job is usually only microseconds away, then sleeps.
+    template <typename Type>
+    static void waitForChange(const std::atomic<Type>& value, Type old)
+    {
+        for (auto i = 0; i < 4096; ++i)
+            if (value.load(std::memory_order_acquire) != old)
+                return;
+
+        value.wait(old, std::memory_order_acquire);
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    void (*job)(void*, int) = nullptr;
+    void* jobContext = nullptr;
+    std::atomic<int> pending{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};
@@ -0,0 +1,112 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Power of everything in the spectrum of the last 2^fftOrder samples of `output` that is
+// not a harmonic of `signalBin`, over the power of the harmonics, in dB.
+static double getAliasToSignalDb(const AudioBuffer<float>& output, int signalBin, int fftOrder)
+{
+    const auto fftSize = 1 << fftOrder;
+
+    std::vector<float> data((size_t)fftSize * 2);
+    const auto* samples = output.getReadPointer(0, output.getNumSamples() - fftSize);
+    std::copy(samples, samples + fftSize, data.begin());
+
+    dsp::FFT(fftOrder).performFrequencyOnlyForwardTransform(data.data(), true);
+
+    auto signalPower = 0.0, aliasPower = 0.0;
+
+    for (auto bin = 1; bin < fftSize / 2; ++bin)
+    {
+        const auto power = (double)data[(size_t)bin] * (double)data[(size_t)bin];
+        (bin % signalBin == 0 ? signalPower : aliasPower) += power;
+    }
+
+    return 10.0 * std::log10(jmax(aliasPower, 1.0e-30) / jmax(signalPower, 1.0e-30));
+}
+
+// Alias rejection and cost of the anti-aliasing options: a sine at a fifth of the sample
+// rate, driven 18 dB into the tanh and hard clip shapers, with every oversampling choice
+// and every ADAA order. The sine sits exactly on an odd FFT bin, so its harmonics below
+// Nyquist land on multiples of it and the aliases folding back from above do not; all the
+// rest of the spectrum counts as aliasing. The output is analysed after a settling time.
+var runAliasSuite(const Options& options)
+{
+    constexpr auto fftOrder = 14;
+    constexpr auto fftSize = 1 << fftOrder;
+    constexpr auto signalBin = (fftSize / 5) | 1;
+
+    const PluginProcessor prototype;
+    const auto& choices = prototype.getParameterValues().processor2Group;
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        AudioBuffer<float> sine(numChannels, fftSize * 4);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+            for (auto i = 0; i < sine.getNumSamples(); ++i)
+                sine.setSample(
+                    channel, i, 0.5f * (float)std::sin(MathConstants<double>::twoPi * signalBin * i / fftSize)
+                );
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                for (const auto typeName : {"Tanh", "Hard clip"})
+                {
+                    for (auto order = 0; order < choices.antialiasing.choices.size(); ++order)
+                    {
+                        for (auto oversampling = 0; oversampling < choices.oversampler.choices.size(); ++oversampling)
+                        {
+                            auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                            const auto& state = processor->getParameterValues().processor2Group;
+                            state.type = state.type.choices.indexOf(typeName);
+                            state.antialiasing = order;
+                            state.oversampler = oversampling;
+                            state.inGain.setValueNotifyingHost(state.inGain.convertTo0to1(18.0f));
+                            processor->prepareToPlay(sampleRate, blockSize);
+
+                            AudioBuffer<float> output(sine);
+                            MidiBuffer midi;
+
+                            for (auto start = 0; start < output.getNumSamples(); start += blockSize)
+                            {
+                                const auto length = jmin(blockSize, output.getNumSamples() - start);
+                                AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, start, length);
+                                processor->processBlock(block, midi);
+                            }
+
+                            const auto aliasToSignalDb = getAliasToSignalDb(output, signalBin, fftOrder);
+
+                            processor->reset();
+                            auto result = measureProcessBlock(*processor, sine, options.secondsPerCase);
+
+                            if (auto* object = result.getDynamicObject())
+                            {
+                                object->setProperty("sampleRate", sampleRate);
+                                object->setProperty("blockSize", blockSize);
+                                object->setProperty("channels", numChannels);
+                                object->setProperty("processor2Type", typeName);
+                                object->setProperty("processor2Antialiasing", order);
+                                object->setProperty("processor2Oversampler", oversampling);
+                                object->setProperty("signalHz", sampleRate * signalBin / fftSize);
+                                object->setProperty("aliasToSignalDb", aliasToSignalDb);
+                                object->setProperty("latencySamples", processor->getLatencySamples());
+                            }
+
+                            results.add(result);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,208 @@
+#include "Bench.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+#endif
+
+namespace bench
+{
+//==============================================================================
+// A hardware cache miss counter for this thread, where the kernel lets us have one.
+class CacheMissCounter
+{
+  public:
+    enum class Level
+    {
+        l1Data,   // L1 data cache read misses
+        lastLevel // misses that went to memory
+    };
+
+    explicit CacheMissCounter(Level level)
+    {
+       #if JUCE_LINUX
+        perf_event_attr attributes{};
+        attributes.size = sizeof(attributes);
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        if (level == Level::l1Data)
+        {
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+        else
+        {
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        }
+
+        descriptor = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+       #else
+        ignoreUnused(level);
+       #endif
+    }
+
+    ~CacheMissCounter()
+    {
+       #if JUCE_LINUX
+        if (descriptor >= 0)
+            close(descriptor);
+       #endif
+    }
+
+    // How many misses `func` caused, or -1 without a counter.
+    template <typename Func>
+    int64 count(Func&& func)
+    {
+       #if JUCE_LINUX
+        if (descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            func();
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+            int64 value = 0;
+            return read(descriptor, &value, sizeof(value)) == (ssize_t)sizeof(value) ? value : -1;
+        }
+       #endif
+
+        func();
+        return -1;
+    }
+
+  private:
+    int descriptor = -1;
+};
+
+// Processes the first numBlocks * blockSize samples of `buffer` in place, block by block.
+template <typename SampleType>
+static void processBlocks(PluginProcessor& processor, AudioBuffer<SampleType>& buffer, int blockSize, int numBlocks)
+{
+    MidiBuffer midi;
+
+    for (auto i = 0; i < numBlocks; ++i)
+    {
+        AudioBuffer<SampleType> block(
+            buffer.getArrayOfWritePointers(), buffer.getNumChannels(), i * blockSize, blockSize
+        );
+        processor.processBlock(block, midi);
+    }
+}
+
+//==============================================================================
+// One instance prepared over and over, cycling through every sample rate and block size as
+// a host does when the session settings change. For each setting: prepareToPlay time
+// (median and worst over the rounds), the size of the state arena, and after each prepare
+// the cache misses per processed block and ns/sample, with the chain state freshly laid
+// out. Cache misses are -1 where perf counters aren't available.
+var runArenaSuite(const Options& options)
+{
+    constexpr auto numRounds = 20;
+    constexpr auto blocksPerRound = 64;
+
+    CacheMissCounter l1Misses(CacheMissCounter::Level::l1Data);
+    CacheMissCounter lastLevelMisses(CacheMissCounter::Level::lastLevel);
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        auto processor = createProcessor(
+            numChannels, options.sampleRates[0], options.blockSizes[0], options.doublePrecision
+        );
+
+        struct Setting
+        {
+            double sampleRate;
+            int blockSize;
+            std::vector<double> prepareMs;
+            int64 l1 = 0, lastLevel = 0;
+            double processSeconds = 0.0;
+            size_t arenaBytes = 0;
+        };
+
+        std::vector<Setting> settings;
+
+        for (const auto sampleRate : options.sampleRates)
+            for (const auto blockSize : options.blockSizes)
+                settings.push_back({sampleRate, blockSize, {}});
+
+        // processed in place, refilled outside the measurements
+        const auto maximumBlockSize = *std::max_element(options.blockSizes.begin(), options.blockSizes.end());
+        const auto floatInput = createNoise(numChannels, maximumBlockSize * blocksPerRound);
+        const auto doubleInput = createNoise<double>(numChannels, maximumBlockSize * blocksPerRound);
+        auto floatBuffer = floatInput;
+        auto doubleBuffer = doubleInput;
+
+        const auto refill = [&]
+        {
+            if (options.doublePrecision)
+                doubleBuffer.makeCopyOf(doubleInput, true);
+            else
+                floatBuffer.makeCopyOf(floatInput, true);
+        };
+
+        for (auto round = 0; round < numRounds; ++round)
+        {
+            for (auto& setting : settings)
+            {
+                processor->setPlayConfigDetails(numChannels, numChannels, setting.sampleRate, setting.blockSize);
+
+                const auto start = Time::getHighResolutionTicks();
+                processor->prepareToPlay(setting.sampleRate, setting.blockSize);
+                setting.prepareMs.push_back(
+                    Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0
+                );
+                setting.arenaBytes = processor->getStateArenaSize();
+
+                const auto run = [&]
+                {
+                    if (options.doublePrecision)
+                        processBlocks(*processor, doubleBuffer, setting.blockSize, blocksPerRound);
+                    else
+                        processBlocks(*processor, floatBuffer, setting.blockSize, blocksPerRound);
+                };
+
+                refill();
+                const auto processStart = Time::getHighResolutionTicks();
+                setting.l1 += l1Misses.count(run);
+                setting.processSeconds +=
+                    Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - processStart);
+
+                refill();
+                setting.lastLevel += lastLevelMisses.count(run);
+            }
+        }
+
+        for (auto& setting : settings)
+        {
+            std::sort(setting.prepareMs.begin(), setting.prepareMs.end());
+
+            const auto numBlocks = (double)numRounds * blocksPerRound;
+            const auto perBlock = [&](int64 misses) { return misses < 0 ? -1.0 : (double)misses / numBlocks; };
+
+            auto* result = new DynamicObject();
+            result->setProperty("sampleRate", setting.sampleRate);
+            result->setProperty("blockSize", setting.blockSize);
+            result->setProperty("channels", numChannels);
+            result->setProperty("doublePrecision", options.doublePrecision);
+            result->setProperty("rounds", numRounds);
+            result->setProperty("prepareMsP50", setting.prepareMs[setting.prepareMs.size() / 2]);
+            result->setProperty("prepareMsMax", setting.prepareMs.back());
+            result->setProperty("arenaBytes", (int64)setting.arenaBytes);
+            result->setProperty("l1dMissesPerBlock", perBlock(setting.l1));
+            result->setProperty("cacheMissesPerBlock", perBlock(setting.lastLevel));
+            result->setProperty("nsPerSample", setting.processSeconds * 1.0e9 / (numBlocks * setting.blockSize));
+            results.add(result);
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,74 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Measures processBlock while the continuous Processor2 and main parameters are moved by a
+// slow LFO every block, once with parameters read per host block and once per sub-block,
+// so the cost of sample-accurate automation shows at small and large block sizes.
+template <typename SampleType>
+static var runAutomationSweep(const Options& options)
+{
+    using Mode = PluginProcessor::AutomationMode;
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        const auto noise = createNoise<SampleType>(numChannels, 1 << 16);
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                for (const auto oversampling : options.oversamplingIndices)
+                {
+                    for (const auto mode : {Mode::perBlock, Mode::subBlock})
+                    {
+                        auto processor = createProcessor(numChannels, sampleRate, blockSize, options.doublePrecision);
+                        const auto& values = processor->getParameterValues();
+
+                        values.processor2Group.oversampler = oversampling;
+                        processor->setAutomationMode(mode);
+                        processor->reset();
+
+                        const auto automate = [&](int blockIndex)
+                        {
+                            const auto phase = MathConstants<double>::twoPi * 0.5 * blockIndex * blockSize / sampleRate;
+                            const auto value = (float)(0.5 + 0.5 * std::sin(phase));
+
+                            for (auto* param : {&values.processor2Group.lowpass,
+                                                &values.processor2Group.highpass,
+                                                &values.processor2Group.mix,
+                                                &values.mainGroup.mix})
+                                param->setValueNotifyingHost(value);
+                        };
+
+                        auto result = measureProcessBlock(*processor, noise, options.secondsPerCase, automate);
+
+                        if (auto* object = result.getDynamicObject())
+                        {
+                            object->setProperty("sampleRate", sampleRate);
+                            object->setProperty("blockSize", blockSize);
+                            object->setProperty("channels", numChannels);
+                            object->setProperty("processor2Oversampler", oversampling);
+                            object->setProperty("automationMode", mode == Mode::subBlock ? "subBlock" : "perBlock");
+                            object->setProperty("doublePrecision", options.doublePrecision);
+                        }
+
+                        results.add(result);
+                    }
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+var runAutomationSuite(const Options& options)
+{
+    return options.doublePrecision ? runAutomationSweep<double>(options) : runAutomationSweep<float>(options);
+}
+
+} // namespace bench
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "PluginProcessor.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+namespace bench
+{
+//==============================================================================
+// Sweep settings shared by all suites, filled from the command line.
+struct Options
+{
+    static Options fromArguments(const ArgumentList& args)
+    {
+        Options options;
+
+        const auto readList = [&](StringRef option, auto& list)
+        {
+            if (!args.containsOption(option))
+                return;
+
+            list.clear();
+
+            for (const auto& token : StringArray::fromTokens(args.getValueForOption(option), ",", ""))
+                list.add(static_cast<std::remove_reference_t<decltype(list[0])>>(token.getDoubleValue()));
+        };
+
+        readList("--sample-rates", options.sampleRates);
+        readList("--block-sizes", options.blockSizes);
+        readList("--channels", options.channelCounts);
+        readList("--oversampling", options.oversamplingIndices);
+
+        options.doublePrecision = args.containsOption("--double");
+
+        if (args.containsOption("--seconds"))
+            options.secondsPerCase = jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+        if (args.containsOption("--instances"))
+            options.numInstances = jmax(1, args.getValueForOption("--instances").getIntValue());
+
+        return options;
+    }
+
+    Array<double> sampleRates{44100.0, 48000.0, 96000.0};
+    Array<int> blockSizes{32, 64, 128, 256, 512, 1024};
+    Array<int> channelCounts{1, 2};
+    Array<int> oversamplingIndices{0}; // processor2Oversampling choice indices
+    double secondsPerCase = 2.0;
+    int numInstances = 0; // memory, state, oversampler and startup suites, 0 for the suite's own default
+    bool doublePrecision = false;
+
+    int getNumInstances(int suiteDefault) const
+    {
+        return numInstances > 0 ? numInstances : suiteDefault;
+    }
+};
+
+//==============================================================================
+// Collects wall-clock time per processed block and reduces it to the reported figures.
+class BlockTimer
+{
+  public:
+    void reserve(size_t numBlocks)
+    {
+        nanoseconds.reserve(numBlocks);
+    }
+
+    template <typename Func>
+    void measure(Func&& func)
+    {
+        const auto start = Time::getHighResolutionTicks();
+        func();
+        const auto end = Time::getHighResolutionTicks();
+
+        nanoseconds.push_back(Time::highResolutionTicksToSeconds(end - start) * 1.0e9);
+    }
+
+    // ns/sample is per sample frame, i.e. independent of the channel count
+    var toVar(int samplesPerBlock, double sampleRate) const
+    {
+        auto sorted = nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto percentile = [&](double p)
+        {
+            if (sorted.empty())
+                return 0.0;
+
+            return sorted[std::min(sorted.size() - 1, (size_t)(p * (double)(sorted.size() - 1) + 0.5))];
+        };
+
+        const auto totalNs = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+        const auto totalSamples = (double)sorted.size() * samplesPerBlock;
+        const auto audioNs = totalSamples / sampleRate * 1.0e9;
+
+        auto* result = new DynamicObject();
+        result->setProperty("blocks", (int)sorted.size());
+        result->setProperty("nsPerSample", totalSamples > 0.0 ? totalNs / totalSamples : 0.0);
+        result->setProperty("p50Us", percentile(0.5) / 1000.0);
+        result->setProperty("p99Us", percentile(0.99) / 1000.0);
+        result->setProperty("maxUs", sorted.empty() ? 0.0 : sorted.back() / 1000.0);
+        result->setProperty("realtimeFactor", totalNs > 0.0 ? audioNs / totalNs : 0.0);
+        return result;
+    }
+
+  private:
+    std::vector<double> nanoseconds;
+};
+
+//==============================================================================
+// Creates a processor the way a host would: bus layout and precision first, then prepareToPlay.
+// It runs as an offline bounce, so oversampling changes take effect on the next block instead
+// of whenever the background thread gets to them.
+inline std::unique_ptr<PluginProcessor> createProcessor(
+    int numChannels, double sampleRate, int samplesPerBlock, bool doublePrecision = false
+)
+{
+    auto processor = std::make_unique<PluginProcessor>();
+    processor->setNonRealtime(true);
+    processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, samplesPerBlock);
+    processor->setProcessingPrecision(doublePrecision ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision);
+    processor->prepareToPlay(sampleRate, samplesPerBlock);
+    return processor;
+}
+
+// Deterministic noise at -12 dBFS so every run processes the same material.
+template <typename SampleType = float>
+AudioBuffer<SampleType> createNoise(int numChannels, int numSamples, int64 seed = 1234)
+{
+    AudioBuffer<SampleType> noise(numChannels, numSamples);
+    Random random(seed);
+
+    for (auto channel = 0; channel < numChannels; ++channel)
+        for (auto i = 0; i < numSamples; ++i)
+            noise.setSample(channel, i, (SampleType)((random.nextFloat() * 2.0f - 1.0f) * 0.25f));
+
+    return noise;
+}
+
+// Runs processBlock over `seconds` of audio, copying fresh input in outside of the timed region.
+// `beforeBlock` gets the block index and runs untimed too, e.g. to automate parameters.
+template <typename SampleType>
+var measureProcessBlock(
+    PluginProcessor& processor,
+    const AudioBuffer<SampleType>& input,
+    double seconds,
+    const std::function<void(int)>& beforeBlock = {}
+)
+{
+    const auto sampleRate = processor.getSampleRate();
+    const auto samplesPerBlock = processor.getBlockSize();
+    const auto numChannels = input.getNumChannels();
+    const auto numInputBlocks = jmax(1, input.getNumSamples() / samplesPerBlock);
+
+    AudioBuffer<SampleType> buffer(numChannels, samplesPerBlock);
+    MidiBuffer midi;
+
+    const auto copyInput = [&](int blockIndex)
+    {
+        const auto offset = (blockIndex % numInputBlocks) * samplesPerBlock;
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom(channel, 0, input, channel, offset, samplesPerBlock);
+
+        if (beforeBlock)
+            beforeBlock(blockIndex);
+    };
+
+    // warm up caches, parameter ramps and the branch predictor
+    const auto warmupBlocks = jmax(8, roundToInt(0.25 * sampleRate / samplesPerBlock));
+
+    for (auto i = 0; i < warmupBlocks; ++i)
+    {
+        copyInput(i);
+        processor.processBlock(buffer, midi);
+    }
+
+    const auto numBlocks = jmax(1, roundToInt(seconds * sampleRate / samplesPerBlock));
+
+    BlockTimer timer;
+    timer.reserve((size_t)numBlocks);
+
+    for (auto i = 0; i < numBlocks; ++i)
+    {
+        copyInput(i);
+        timer.measure([&] { processor.processBlock(buffer, midi); });
+    }
+
+    return timer.toVar(samplesPerBlock, sampleRate);
+}
+
+// Resident set size of this process, 0 where we don't know how to read it.
+inline int64 getResidentBytes()
+{
+   #if JUCE_LINUX
+    const auto fields = StringArray::fromTokens(File("/proc/self/statm").loadFileAsString(), true);
+    return fields[1].getLargeIntValue() * (int64)sysconf(_SC_PAGESIZE);
+   #elif JUCE_MAC
+    mach_task_basic_info info{};
+    auto count = (mach_msg_type_number_t)MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+
+    return (int64)info.resident_size;
+   #else
+    return 0;
+   #endif
+}
+
+#if MY_STAGE_PROFILING
+// Cycles per stage since the histograms were last reset, see StageProfiler.h.
+inline var getStageProfile(PluginProcessor& processor)
+{
+    const auto summaries = processor.getStageHistograms().getSummaries();
+    auto* stages = new DynamicObject();
+
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        const auto& summary = summaries[i];
+
+        auto* stage = new DynamicObject();
+        stage->setProperty("calls", (int64)summary.calls);
+        stage->setProperty("meanCycles", summary.meanCycles);
+        stage->setProperty("p50Cycles", (int64)summary.p50Cycles);
+        stage->setProperty("p99Cycles", (int64)summary.p99Cycles);
+        stage->setProperty("share", summary.share);
+        stages->setProperty(StageProfiler::stageNames[i], stage);
+    }
+
+    return stages;
+}
+#endif
+
+//==============================================================================
+var runProcessBlockSuite(const Options&);
+var runMemorySuite(const Options&);
+var runAutomationSuite(const Options&);
+var runLatencySuite(const Options&);
+var runIdentitySuite(const Options&);
+var runChannelScalingSuite(const Options&);
+var runStateSuite(const Options&);
+var runOfflineSuite(const Options&);
+var runShaperSuite(const Options&);
+var runAliasSuite(const Options&);
+var runOversamplerSuite(const Options&);
+var runStartupSuite(const Options&);
+var runArenaSuite(const Options&);
+var runShaperSwitchSuite(const Options&);
+
+} // namespace bench
@@ -0,0 +1,103 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Renders `numBlocks` blocks of `input` and returns everything the processor produced.
+static AudioBuffer<float> render(PluginProcessor& processor, const AudioBuffer<float>& input, int numBlocks)
+{
+    const auto numChannels = input.getNumChannels();
+    const auto samplesPerBlock = processor.getBlockSize();
+    const auto numInputBlocks = jmax(1, input.getNumSamples() / samplesPerBlock);
+
+    AudioBuffer<float> output(numChannels, numBlocks * samplesPerBlock);
+    AudioBuffer<float> buffer(numChannels, samplesPerBlock);
+    MidiBuffer midi;
+
+    for (auto i = 0; i < numBlocks; ++i)
+    {
+        for (auto channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom(channel, 0, input, channel, (i % numInputBlocks) * samplesPerBlock, samplesPerBlock);
+
+        processor.processBlock(buffer, midi);
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+            output.copyFrom(channel, i * samplesPerBlock, buffer, channel, 0, samplesPerBlock);
+    }
+
+    return output;
+}
+
+static bool isIdentical(const AudioBuffer<float>& a, const AudioBuffer<float>& b)
+{
+    for (auto channel = 0; channel < a.getNumChannels(); ++channel)
+        if (std::memcmp(a.getReadPointer(channel), b.getReadPointer(channel), sizeof(float) * (size_t)a.getNumSamples()) != 0)
+            return false;
+
+    return true;
+}
+
+// processBlock cost from 2 to 64 channels with 1, 2, 4, ... channel groups (up to the number
+// of cores), and whether each grouping renders bit-identical output to serial processing.
+var runChannelScalingSuite(const Options& options)
+{
+    Array<var> results;
+
+    for (const auto sampleRate : options.sampleRates)
+    {
+        for (const auto blockSize : options.blockSizes)
+        {
+            for (const auto oversampling : options.oversamplingIndices)
+            {
+                for (const auto numChannels : {2, 4, 8, 16, 32, 64})
+                {
+                    const auto noise = createNoise<float>(numChannels, 1 << 15);
+                    const auto numRenderBlocks = jmax(1, roundToInt(0.5 * sampleRate / blockSize));
+
+                    AudioBuffer<float> reference;
+                    auto serialNsPerSample = 0.0;
+
+                    for (auto groups = 1; groups <= jmin(numChannels, SystemStats::getNumCpus()); groups *= 2)
+                    {
+                        auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                        processor->setMaxChannelGroups(groups);
+                        processor->prepareToPlay(sampleRate, blockSize);
+
+                        processor->getParameterValues().processor2Group.oversampler = oversampling;
+                        processor->reset();
+
+                        const auto output = render(*processor, noise, numRenderBlocks);
+
+                        if (groups == 1)
+                            reference = output;
+
+                        processor->reset();
+                        auto result = measureProcessBlock(*processor, noise, options.secondsPerCase);
+
+                        if (auto* object = result.getDynamicObject())
+                        {
+                            const auto nsPerSample = (double)object->getProperty("nsPerSample");
+
+                            if (groups == 1)
+                                serialNsPerSample = nsPerSample;
+
+                            object->setProperty("sampleRate", sampleRate);
+                            object->setProperty("blockSize", blockSize);
+                            object->setProperty("channels", numChannels);
+                            object->setProperty("channelGroups", groups);
+                            object->setProperty("processor2Oversampler", oversampling);
+                            object->setProperty("speedup", nsPerSample > 0.0 ? serialNsPerSample / nsPerSample : 0.0);
+                            object->setProperty("identicalToSerial", isIdentical(output, reference));
+                        }
+
+                        results.add(result);
+                    }
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,143 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// The identity fast path (Processor2 off, unity gains) against a plain copy of the block and
+// against the same settings with a non-unity input gain. Then Processor2 is toggled every
+// 50 ms on a sine, at 100% and 50% mix, and the largest sample-to-sample step of the output
+// is compared with the sine's own, which a click on any transition would exceed.
+var runIdentitySuite(const Options& options)
+{
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        const auto noise = createNoise<float>(numChannels, 1 << 16);
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                const auto numBlocks = jmax(1, roundToInt(options.secondsPerCase * sampleRate / blockSize));
+
+                const auto addResult = [&](const String& name, var result)
+                {
+                    if (auto* object = result.getDynamicObject())
+                    {
+                        object->setProperty("case", name);
+                        object->setProperty("sampleRate", sampleRate);
+                        object->setProperty("blockSize", blockSize);
+                        object->setProperty("channels", numChannels);
+                    }
+
+                    results.add(result);
+                };
+
+                {
+                    AudioBuffer<float> buffer(numChannels, blockSize);
+                    BlockTimer timer;
+                    timer.reserve((size_t)numBlocks);
+
+                    for (auto i = 0; i < numBlocks; ++i)
+                    {
+                        const auto offset = (i % (noise.getNumSamples() / blockSize)) * blockSize;
+
+                        timer.measure(
+                            [&]
+                            {
+                                for (auto channel = 0; channel < numChannels; ++channel)
+                                    buffer.copyFrom(channel, 0, noise, channel, offset, blockSize);
+                            }
+                        );
+                    }
+
+                    addResult("copy", timer.toVar(blockSize, sampleRate));
+                }
+
+                auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                const auto& values = processor->getParameterValues();
+
+                values.processor2Group.enabled = false;
+                processor->reset();
+                addResult("identity", measureProcessBlock(*processor, noise, options.secondsPerCase));
+
+                auto& inputGain = values.mainGroup.inputGain;
+
+                inputGain.setValueNotifyingHost(inputGain.convertTo0to1(-6.0f));
+                processor->reset();
+                addResult("inputGain", measureProcessBlock(*processor, noise, options.secondsPerCase));
+
+                inputGain.setValueNotifyingHost(inputGain.convertTo0to1(0.0f));
+
+                // below 100% the dry signal is mixed in at Processor2's latency, so it has to
+                // be there already when Processor2 fades back in
+                for (const auto mixPercent : {100.0f, 50.0f})
+                {
+                    auto& mix = values.mainGroup.mix;
+                    mix.setValueNotifyingHost(mix.convertTo0to1(mixPercent));
+                    values.processor2Group.enabled = false;
+                    processor->reset();
+
+                    AudioBuffer<float> buffer(numChannels, blockSize);
+                    MidiBuffer midi;
+
+                    constexpr auto frequency = 100.0;
+                    constexpr auto amplitude = 0.25;
+                    const auto togglePeriod = jmax(1, roundToInt(0.05 * sampleRate / blockSize));
+
+                    std::vector<float> previous((size_t)numChannels, 0.0f);
+                    auto maxStep = 0.0f;
+                    auto toggles = 0;
+
+                    for (auto i = 0; i < numBlocks; ++i)
+                    {
+                        for (auto sample = 0; sample < blockSize; ++sample)
+                        {
+                            const auto time = (i * blockSize + sample) / sampleRate;
+                            const auto phase = MathConstants<double>::twoPi * frequency * time;
+
+                            for (auto channel = 0; channel < numChannels; ++channel)
+                                buffer.setSample(channel, sample, (float)(amplitude * std::sin(phase)));
+                        }
+
+                        if (i % togglePeriod == 0)
+                        {
+                            values.processor2Group.enabled = !values.processor2Group.enabled;
+                            ++toggles;
+                        }
+
+                        processor->processBlock(buffer, midi);
+
+                        for (auto channel = 0; channel < numChannels; ++channel)
+                        {
+                            for (auto sample = 0; sample < blockSize; ++sample)
+                            {
+                                const auto value = buffer.getSample(channel, sample);
+
+                                if (i > 0 || sample > 0)
+                                    maxStep = jmax(maxStep, std::abs(value - previous[(size_t)channel]));
+
+                                previous[(size_t)channel] = value;
+                            }
+                        }
+                    }
+
+                    const auto inputMaxStep = amplitude * MathConstants<double>::twoPi * frequency / sampleRate;
+
+                    auto* toggle = new DynamicObject();
+                    toggle->setProperty("mix", mixPercent);
+                    toggle->setProperty("toggles", toggles);
+                    toggle->setProperty("maxStep", maxStep);
+                    toggle->setProperty("inputMaxStep", inputMaxStep);
+                    toggle->setProperty("clickFree", maxStep < 2.0 * inputMaxStep);
+                    addResult("toggle", toggle);
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,96 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Counts the latency-change notifications a host would see: none while processing with
+// fixed settings, and exactly one per real change when toggling Processor2 and switching
+// oversampling factors.
+var runLatencySuite(const Options& options)
+{
+    struct NotificationCounter final : public AudioProcessorListener
+    {
+        void audioProcessorParameterChanged(AudioProcessor*, int, float) override
+        {
+        }
+
+        void audioProcessorChanged(AudioProcessor*, const ChangeDetails& details) override
+        {
+            if (details.latencyChanged)
+                ++latencyNotifications;
+        }
+
+        int latencyNotifications = 0;
+    };
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        const auto noise = createNoise<float>(numChannels, 1 << 16);
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                const auto& state = processor->getParameterValues().processor2Group;
+
+                NotificationCounter counter;
+                processor->addListener(&counter);
+
+                const auto run = [&](double seconds)
+                {
+                    measureProcessBlock(*processor, noise, seconds);
+
+                    // delivers the processor's asynchronous latency update
+                    MessageManager::getInstance()->runDispatchLoopUntil(120);
+                };
+
+                run(options.secondsPerCase);
+                const auto steadyStateNotifications = counter.latencyNotifications;
+
+                // every setting change, counting the ones that really move the latency
+                auto latencyChanges = 0;
+                auto latency = processor->getLatencySamples();
+
+                for (auto index = 0; index < state.oversampler.choices.size(); ++index)
+                {
+                    for (const auto enabled : {false, true})
+                    {
+                        state.oversampler = index;
+                        state.enabled = enabled;
+                        run(0.05);
+
+                        const auto newLatency = processor->getLatencySamples();
+
+                        if (newLatency != latency)
+                            ++latencyChanges;
+
+                        latency = newLatency;
+                    }
+                }
+
+                const auto changeNotifications = counter.latencyNotifications - steadyStateNotifications;
+
+                processor->removeListener(&counter);
+
+                auto* result = new DynamicObject();
+                result->setProperty("sampleRate", sampleRate);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("channels", numChannels);
+                result->setProperty("steadyStateNotifications", steadyStateNotifications);
+                result->setProperty("latencyChanges", latencyChanges);
+                result->setProperty("changeNotifications", changeNotifications);
+                result->setProperty(
+                    "passed", steadyStateNotifications == 0 && changeNotifications == latencyChanges
+                );
+                results.add(result);
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
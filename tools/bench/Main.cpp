@@ -0,0 +1,70 @@
+#include "Bench.h"
+
+//==============================================================================
+// Offline benchmark harness for PluginProcessor.
+//
+// usage: myPluginBench [--suite=<name>] [--output=<file.json>] [--seconds=<per case>]
+//                      [--sample-rates=44100,48000] [--block-sizes=64,512] [--channels=1,2]
+//                      [--oversampling=0,2] [--double] [--instances=<count>]
+//
+// Results are printed as JSON (and written to --output if given), so they can be
+// diffed against a previous run to catch regressions. Exits with 1 if a suite that checks
+// its cases (latency, offline, shaperSwitch) had one fail.
+int main(int argc, char* argv[])
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+    const ArgumentList args(argc, argv);
+
+    const std::map<String, std::function<var(const bench::Options&)>> suites{
+        {"processBlock", bench::runProcessBlockSuite},
+        {"memory", bench::runMemorySuite},
+        {"automation", bench::runAutomationSuite},
+        {"latency", bench::runLatencySuite},
+        {"identity", bench::runIdentitySuite},
+        {"channels", bench::runChannelScalingSuite},
+        {"state", bench::runStateSuite},
+        {"offline", bench::runOfflineSuite},
+        {"shaper", bench::runShaperSuite},
+        {"alias", bench::runAliasSuite},
+        {"oversampler", bench::runOversamplerSuite},
+        {"startup", bench::runStartupSuite},
+        {"arena", bench::runArenaSuite},
+        {"shaperSwitch", bench::runShaperSwitchSuite},
+    };
+
+    const auto suiteName = args.containsOption("--suite") ? args.getValueForOption("--suite") : String("processBlock");
+    const auto suite = suites.find(suiteName);
+
+    if (suite == suites.end())
+    {
+        std::cerr << "unknown suite: " << suiteName << std::endl;
+        return 1;
+    }
+
+    auto* root = new DynamicObject();
+    root->setProperty("suite", suiteName);
+    root->setProperty("cpu", SystemStats::getCpuModel());
+    root->setProperty("date", Time::getCurrentTime().toISO8601(true));
+   #if JUCE_DEBUG
+    root->setProperty("build", "debug");
+   #else
+    root->setProperty("build", "release");
+   #endif
+
+    const auto results = suite->second(bench::Options::fromArguments(args));
+    root->setProperty("results", results);
+
+    const auto json = JSON::toString(var(root));
+    std::cout << json << std::endl;
+
+    if (args.containsOption("--output"))
+        if (!args.getFileForOption("--output").replaceWithText(json))
+            return 1;
+
+    // suites that check something mark each case with "passed", which ctest goes by
+    for (auto i = 0; i < results.size(); ++i)
+        if (results[i].hasProperty("passed") && !(bool)results[i]["passed"])
+            return 1;
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Prepares many instances the way a session load does and reports resident memory and
+// prepareToPlay time per instance, then builds every oversampling factor on all of them
+// for comparison with only the active one.
+var runMemorySuite(const Options& options)
+{
+    const auto numInstances = options.getNumInstances(100);
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                std::vector<std::unique_ptr<PluginProcessor>> processors;
+                processors.reserve((size_t)numInstances);
+
+                const auto residentBefore = getResidentBytes();
+                const auto start = Time::getHighResolutionTicks();
+
+                for (auto i = 0; i < numInstances; ++i)
+                    processors.push_back(createProcessor(numChannels, sampleRate, blockSize, options.doublePrecision));
+
+                const auto prepareSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+                const auto residentPrepared = getResidentBytes();
+
+                for (auto& processor : processors)
+                {
+                    const auto& state = processor->getParameterValues().processor2Group;
+
+                    for (auto index = state.oversampler.choices.size(); --index >= 0;)
+                    {
+                        state.oversampler = index;
+                        processor->reset();
+                    }
+                }
+
+                const auto residentAllFactors = getResidentBytes();
+
+                const auto perInstance = [&](int64 bytes) { return (double)bytes / numInstances; };
+
+                auto* result = new DynamicObject();
+                result->setProperty("sampleRate", sampleRate);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("channels", numChannels);
+                result->setProperty("doublePrecision", options.doublePrecision);
+                result->setProperty("instances", numInstances);
+                result->setProperty("prepareMsPerInstance", prepareSeconds * 1000.0 / numInstances);
+                result->setProperty("residentBytesPerInstance", perInstance(residentPrepared - residentBefore));
+                result->setProperty(
+                    "residentBytesPerInstanceAllFactors", perInstance(residentAllFactors - residentBefore)
+                );
+                results.add(result);
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
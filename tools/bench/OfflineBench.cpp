@@ -0,0 +1,166 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Runs `processor` over `input` in host blocks of its block size and returns the output.
+static AudioBuffer<float> renderOffline(PluginProcessor& processor, const AudioBuffer<float>& input)
+{
+    const auto samplesPerBlock = processor.getBlockSize();
+
+    AudioBuffer<float> output(input);
+    MidiBuffer midi;
+
+    for (auto start = 0; start < output.getNumSamples(); start += samplesPerBlock)
+    {
+        const auto length = jmin(samplesPerBlock, output.getNumSamples() - start);
+        AudioBuffer<float> block(output.getArrayOfWritePointers(), output.getNumChannels(), start, length);
+        processor.processBlock(block, midi);
+    }
+
+    return output;
+}
+
+// Largest difference between `delayed` and `plain` shifted by `shift` samples.
+static float getMaxDifference(const AudioBuffer<float>& delayed, const AudioBuffer<float>& plain, int shift)
+{
+    auto maxDifference = 0.0f;
+
+    for (auto channel = 0; channel < plain.getNumChannels(); ++channel)
+        for (auto i = jmax(0, -shift); i + shift < delayed.getNumSamples(); ++i)
+            maxDifference =
+                jmax(maxDifference, std::abs(delayed.getSample(channel, i + shift) - plain.getSample(channel, i)));
+
+    return maxDifference;
+}
+
+// Offline render throughput at the host's block sizes, processing them as they come and
+// gathered into internal blocks of 1024 and 4096 samples, with and without the high
+// quality shaper and oversampling. For the standard quality accumulated renders it also
+// checks that the output is the plain render delayed by exactly the added latency.
+// Finally the settings come with a saved state, as a host restores them, and only the
+// host's offline flag turns them on: they must apply to a bounce and not to playback.
+var runOfflineSuite(const Options& options)
+{
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        const auto noise = createNoise<float>(numChannels, 1 << 16);
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                for (const auto oversampling : options.oversamplingIndices)
+                {
+                    AudioBuffer<float> reference;
+                    auto referenceLatency = 0, highQualityLatency = 0;
+
+                    for (const auto highQuality : {false, true})
+                    {
+                        for (const auto internalBlockSize : {0, 1024, 4096})
+                        {
+                            auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                            processor->getParameterValues().processor2Group.oversampler = oversampling;
+                            processor->setOfflineBlockSize(internalBlockSize);
+                            processor->setOfflineHighQuality(highQuality);
+                            processor->prepareToPlay(sampleRate, blockSize);
+
+                            const auto latency = processor->getLatencySamples();
+
+                            if (highQuality && internalBlockSize == 4096)
+                                highQualityLatency = latency;
+
+                            auto result = measureProcessBlock(*processor, noise, options.secondsPerCase);
+
+                            if (auto* object = result.getDynamicObject())
+                            {
+                                object->setProperty("sampleRate", sampleRate);
+                                object->setProperty("blockSize", blockSize);
+                                object->setProperty("channels", numChannels);
+                                object->setProperty("processor2Oversampler", oversampling);
+                                object->setProperty("internalBlockSize", internalBlockSize);
+                                object->setProperty("highQuality", highQuality);
+                                object->setProperty("latencySamples", latency);
+
+                                if (!highQuality)
+                                {
+                                    processor->reset();
+                                    const auto output = renderOffline(*processor, noise);
+
+                                    if (internalBlockSize == 0)
+                                    {
+                                        reference = output;
+                                        referenceLatency = latency;
+                                    }
+                                    else
+                                    {
+                                        // accumulation may only add its own block size
+                                        const auto shift = latency - referenceLatency;
+                                        const auto maxDifference = getMaxDifference(output, reference, shift);
+
+                                        object->setProperty("maxDifferenceToPlainRender", maxDifference);
+                                        object->setProperty(
+                                            "passed", shift == internalBlockSize && maxDifference < 1.0e-4f
+                                        );
+                                    }
+                                }
+                            }
+
+                            results.add(result);
+                        }
+                    }
+
+                    MemoryBlock state;
+
+                    {
+                        PluginProcessor saved;
+                        const auto& values = saved.getParameterValues();
+                        auto& blockSizeSetting = values.settingsGroup.offlineBlockSize;
+
+                        values.processor2Group.oversampler = oversampling;
+                        blockSizeSetting.setValueNotifyingHost(
+                            blockSizeSetting.convertTo0to1((float)blockSizeSetting.choices.indexOf("4096"))
+                        );
+                        values.settingsGroup.offlineQuality.setValueNotifyingHost(1.0f);
+                        saved.getStateInformation(state);
+                    }
+
+                    auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                    processor->setStateInformation(state.getData(), (int)state.getSize());
+
+                    processor->setNonRealtime(false);
+                    processor->prepareToPlay(sampleRate, blockSize);
+                    const auto realtimeLatency = processor->getLatencySamples();
+
+                    processor->setNonRealtime(true);
+                    processor->prepareToPlay(sampleRate, blockSize);
+                    const auto offlineLatency = processor->getLatencySamples();
+
+                    auto result = measureProcessBlock(*processor, noise, options.secondsPerCase);
+
+                    if (auto* object = result.getDynamicObject())
+                    {
+                        object->setProperty("sampleRate", sampleRate);
+                        object->setProperty("blockSize", blockSize);
+                        object->setProperty("channels", numChannels);
+                        object->setProperty("processor2Oversampler", oversampling);
+                        object->setProperty("settings", "session");
+                        object->setProperty("realtimeLatencySamples", realtimeLatency);
+                        object->setProperty("latencySamples", offlineLatency);
+                        object->setProperty(
+                            "passed", realtimeLatency == referenceLatency && offlineLatency == highQualityLatency
+                        );
+                    }
+
+                    results.add(result);
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
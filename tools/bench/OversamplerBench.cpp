@@ -0,0 +1,151 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Builds `numInstances` oversamplers with `create` and returns them, with the time taken
+// and the resident memory added per instance.
+template <typename Factory>
+static auto createInstances(int numInstances, Factory&& create, double& msPerInstance, double& bytesPerInstance)
+{
+    std::vector<decltype(create())> instances;
+    instances.reserve((size_t)numInstances);
+
+    const auto residentBefore = getResidentBytes();
+    const auto start = Time::getHighResolutionTicks();
+
+    for (auto i = 0; i < numInstances; ++i)
+        instances.push_back(create());
+
+    const auto seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+    msPerInstance = seconds * 1000.0 / numInstances;
+    bytesPerInstance = (double)(getResidentBytes() - residentBefore) / numInstances;
+
+    return instances;
+}
+
+// Largest difference between the two oversamplers' outputs for the same noise, with the
+// waveshaper left out, once both have settled.
+template <typename SampleType, typename Reference, typename Shared>
+static double getMaxDifference(Reference& reference, Shared& shared, int numChannels, int blockSize)
+{
+    const auto input = createNoise<SampleType>(numChannels, 1 << 15);
+    AudioBuffer<SampleType> outputs[2]{input, input};
+
+    const auto run = [&](auto& oversampler, AudioBuffer<SampleType>& output)
+    {
+        oversampler.reset();
+
+        for (auto start = 0; start + blockSize <= output.getNumSamples(); start += blockSize)
+        {
+            auto block = dsp::AudioBlock<SampleType>(output).getSubBlock((size_t)start, (size_t)blockSize);
+            oversampler.processSamplesUp(block);
+            oversampler.processSamplesDown(block);
+        }
+    };
+
+    run(reference, outputs[0]);
+    run(shared, outputs[1]);
+
+    auto maxDifference = 0.0;
+
+    for (auto channel = 0; channel < numChannels; ++channel)
+        for (auto i = input.getNumSamples() / 2; i < input.getNumSamples(); ++i)
+            maxDifference = jmax(
+                maxDifference, std::abs((double)outputs[0].getSample(channel, i) - outputs[1].getSample(channel, i))
+            );
+
+    return maxDifference;
+}
+
+// Instance creation with the shared filter designs of PluginProcessor's oversamplers against
+// dsp::Oversampling, which designs them in every instance: time and resident memory per
+// instance to construct and initProcessing each oversampler setting, how many designs the
+// shared cache made for all of them, and how far the two outputs are apart.
+template <typename SampleType>
+static var runOversamplerSweep(const Options& options)
+{
+    using Bank = OversamplerBank<SampleType>;
+    using Reference = dsp::Oversampling<SampleType>;
+
+    const auto numInstances = options.getNumInstances(300);
+    const auto blockSize = options.blockSizes.getLast();
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        for (auto index = 0; index < Bank::size(); ++index)
+        {
+            const auto& setting = Bank::settings[(size_t)index];
+            const auto filterType = setting.filterType == Polyphase::FilterType::halfBandIIR
+                                      ? Reference::filterHalfBandPolyphaseIIR
+                                      : Reference::filterHalfBandFIREquiripple;
+
+            auto referenceMs = 0.0, referenceBytes = 0.0;
+            auto references = createInstances(
+                numInstances,
+                [&]
+                {
+                    auto oversampler = std::make_unique<Reference>(
+                        (size_t)numChannels, setting.stages, filterType, true, setting.integerLatency
+                    );
+                    oversampler->initProcessing((size_t)blockSize);
+                    return oversampler;
+                },
+                referenceMs,
+                referenceBytes
+            );
+
+            // keeps the cache, not the designs, alive between the measurements
+            const SharedResourcePointer<Polyphase::DesignCache<SampleType>> cache;
+            const auto designsBefore = cache->getNumDesigned();
+
+            auto sharedMs = 0.0, sharedBytes = 0.0;
+            auto shared = createInstances(
+                numInstances,
+                [&]
+                {
+                    auto oversampler = std::make_unique<typename Bank::Oversampler>(
+                        (size_t)numChannels, setting.stages, setting.filterType, setting.integerLatency
+                    );
+                    oversampler->initProcessing((size_t)blockSize);
+                    return oversampler;
+                },
+                sharedMs,
+                sharedBytes
+            );
+
+            auto* result = new DynamicObject();
+            result->setProperty("oversamplerIndex", index);
+            result->setProperty("factor", 1 << setting.stages);
+            result->setProperty("linearPhase", setting.filterType == Polyphase::FilterType::halfBandFIREquiripple);
+            result->setProperty("channels", numChannels);
+            result->setProperty("blockSize", blockSize);
+            result->setProperty("doublePrecision", options.doublePrecision);
+            result->setProperty("instances", numInstances);
+            result->setProperty("dspOversamplingMsPerInstance", referenceMs);
+            result->setProperty("sharedMsPerInstance", sharedMs);
+            result->setProperty("speedup", sharedMs > 0.0 ? referenceMs / sharedMs : 0.0);
+            result->setProperty("dspOversamplingBytesPerInstance", referenceBytes);
+            result->setProperty("sharedBytesPerInstance", sharedBytes);
+            result->setProperty("designsMade", cache->getNumDesigned() - designsBefore);
+            result->setProperty("dspOversamplingLatency", references.front()->getLatencyInSamples());
+            result->setProperty("sharedLatency", shared.front()->getLatencyInSamples());
+            result->setProperty(
+                "maxAbsDifference",
+                getMaxDifference<SampleType>(*references.front(), *shared.front(), numChannels, blockSize)
+            );
+            results.add(result);
+        }
+    }
+
+    return results;
+}
+
+var runOversamplerSuite(const Options& options)
+{
+    return options.doublePrecision ? runOversamplerSweep<double>(options) : runOversamplerSweep<float>(options);
+}
+
+} // namespace bench
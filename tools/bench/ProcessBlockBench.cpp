@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// Sweeps sample rate, block size, channel count, oversampling factor, waveshaper type and
+// the Processor2 enable switch through PluginProcessor::processBlock.
+template <typename SampleType>
+static var runProcessBlockSweep(const Options& options)
+{
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        const auto noise = createNoise<SampleType>(numChannels, 1 << 16);
+
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                auto processor = createProcessor(numChannels, sampleRate, blockSize, options.doublePrecision);
+                const auto& state = processor->getParameterValues().processor2Group;
+
+                for (const auto oversampling : options.oversamplingIndices)
+                {
+                    for (const auto bypassed : {false, true})
+                    {
+                        for (auto type = 0; type < state.type.choices.size(); ++type)
+                        {
+                            // the shaper is not run when Processor2 is bypassed
+                            if (bypassed && type > 0)
+                                break;
+
+                            state.type = type;
+                            state.oversampler = oversampling;
+                            state.enabled = !bypassed;
+                            processor->reset();
+
+                           #if MY_STAGE_PROFILING
+                            processor->getStageHistograms().reset();
+                           #endif
+
+                            auto result = measureProcessBlock(*processor, noise, options.secondsPerCase);
+
+                            if (auto* object = result.getDynamicObject())
+                            {
+                                object->setProperty("sampleRate", sampleRate);
+                                object->setProperty("blockSize", blockSize);
+                                object->setProperty("channels", numChannels);
+                                object->setProperty("processor2Type", type);
+                                object->setProperty("processor2Oversampler", oversampling);
+                                object->setProperty("bypassed", bypassed);
+                                object->setProperty("doublePrecision", options.doublePrecision);
+
+                               #if MY_STAGE_PROFILING
+                                object->setProperty("stages", getStageProfile(*processor));
+                               #endif
+                            }
+
+                            results.add(result);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+var runProcessBlockSuite(const Options& options)
+{
+    return options.doublePrecision ? runProcessBlockSweep<double>(options) : runProcessBlockSweep<float>(options);
+}
+
+} // namespace bench
@@ -0,0 +1,198 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// One way of shaping a block in place, and the exact curve it approximates.
+template <typename SampleType>
+struct ShaperMethod
+{
+    String name;
+    String curve;
+    std::function<double(double)> reference;
+    std::function<void(const dsp::AudioBlock<SampleType>&)> process;
+};
+
+// Largest error of `method` against its exact curve over x in [-20, 20].
+template <typename SampleType>
+static double getMaxError(const ShaperMethod<SampleType>& method)
+{
+    constexpr auto numPoints = 400001;
+
+    std::vector<SampleType> x(numPoints), y(numPoints);
+
+    for (auto i = 0; i < numPoints; ++i)
+        x[(size_t)i] = y[(size_t)i] = (SampleType)jmap((double)i, 0.0, numPoints - 1.0, -20.0, 20.0);
+
+    auto* channels = y.data();
+    method.process(dsp::AudioBlock<SampleType>(&channels, 1, y.size()));
+
+    auto maxError = 0.0;
+
+    for (size_t i = 0; i < x.size(); ++i)
+        maxError = jmax(maxError, std::abs((double)y[i] - method.reference((double)x[i])));
+
+    return maxError;
+}
+
+// Speed and accuracy of the waveshaper implementations on their own: std::tanh, the
+// ShaperKernels approximations, dsp::LookupTableTransform and the ShaperTables lookups
+// with linear and cubic interpolation, on the same tanh and on each table curve. The
+// blocks hold noise driven to +-4, as Processor2's shaper would see with some gain.
+template <typename SampleType>
+static var runShaperSweep(const Options& options)
+{
+    using namespace ShaperTables;
+
+    const std::function<double(double)> tanhCurve = [](double x) { return std::tanh(x); };
+    constexpr auto numPoints = (size_t)Tables<SampleType>::numPoints;
+    constexpr auto range = (SampleType)Tables<SampleType>::range;
+
+    const Table<SampleType> tanhTable(tanhCurve, -range, range, (int)numPoints);
+    const dsp::LookupTableTransform<SampleType> tanhTransform(
+        [](SampleType x) { return std::tanh(x); }, -range, range, numPoints
+    );
+    const SharedResourcePointer<Tables<SampleType>> tables;
+
+    std::vector<ShaperMethod<SampleType>> methods;
+
+    methods.push_back(
+        {"std::tanh",
+         "tanh",
+         tanhCurve,
+         [](const auto& block)
+         {
+             for (auto* data = block.getChannelPointer(0), *end = data + block.getNumSamples(); data != end; ++data)
+                 *data = std::tanh(*data);
+         }}
+    );
+
+    methods.push_back(
+        {"kernel", "tanh", tanhCurve, [](const auto& block)
+         { ShaperKernels::process(block, ShaperKernels::Shape::tanh, false, (SampleType)1); }}
+    );
+
+    methods.push_back(
+        {"kernel fastTanh + clip", "tanh", tanhCurve, [](const auto& block)
+         { ShaperKernels::process(block, ShaperKernels::Shape::fastTanh, true, (SampleType)1); }}
+    );
+
+    methods.push_back(
+        {"LookupTableTransform",
+         "tanh",
+         tanhCurve,
+         [&](const auto& block)
+         {
+             auto* data = block.getChannelPointer(0);
+             tanhTransform.process(data, data, block.getNumSamples());
+         }}
+    );
+
+    const std::pair<Curve, String> curves[]{
+        {Curve::asymmetric, "asymmetric"},
+        {Curve::softKnee, "soft knee"},
+        {Curve::foldback, "foldback"},
+    };
+
+    for (const auto& [curve, curveName] : curves)
+    {
+        const std::function<double(double)> exact = [curve = curve](double x) { return evaluate(curve, x); };
+
+        methods.push_back(
+            {"exact", curveName, exact, [curve = curve](const auto& block)
+             { ShaperTables::processExact(block, curve, (SampleType)1); }}
+        );
+    }
+
+    for (const auto interpolation : {Interpolation::linear, Interpolation::cubic})
+    {
+        const String name = interpolation == Interpolation::linear ? "table linear" : "table cubic";
+
+        methods.push_back(
+            {name, "tanh", tanhCurve, [&, interpolation](const auto& block)
+             { ShaperTables::process(block, tanhTable, interpolation, (SampleType)1); }}
+        );
+
+        for (const auto& [curve, curveName] : curves)
+        {
+            methods.push_back(
+                {name,
+                 curveName,
+                 [curve = curve](double x) { return evaluate(curve, x); },
+                 [&, curve = curve, interpolation](const auto& block)
+                 { ShaperTables::process(block, (*tables)[curve], interpolation, (SampleType)1); }}
+            );
+        }
+    }
+
+    std::vector<double> maxErrors;
+
+    for (const auto& method : methods)
+        maxErrors.push_back(getMaxError(method));
+
+    Array<var> results;
+
+    // only scales realtimeFactor
+    constexpr auto sampleRate = 48000.0;
+
+    auto input = createNoise<SampleType>(1, 1 << 16);
+    input.applyGain((SampleType)16);
+
+    for (const auto blockSize : options.blockSizes)
+    {
+        auto stdTanhNsPerSample = 0.0;
+
+        for (size_t m = 0; m < methods.size(); ++m)
+        {
+            const auto& method = methods[m];
+            AudioBuffer<SampleType> buffer(1, blockSize);
+            const auto numInputBlocks = jmax(1, input.getNumSamples() / blockSize);
+
+            const auto run = [&](int blockIndex, auto&& time)
+            {
+                buffer.copyFrom(0, 0, input, 0, (blockIndex % numInputBlocks) * blockSize, blockSize);
+                const dsp::AudioBlock<SampleType> block(buffer);
+                time([&] { method.process(block); });
+            };
+
+            for (auto i = 0; i < 64; ++i)
+                run(i, [](auto&& func) { func(); });
+
+            const auto numBlocks = jmax(1, roundToInt(options.secondsPerCase * sampleRate / blockSize));
+
+            BlockTimer timer;
+            timer.reserve((size_t)numBlocks);
+
+            for (auto i = 0; i < numBlocks; ++i)
+                run(i, [&](auto&& func) { timer.measure(func); });
+
+            auto result = timer.toVar(blockSize, sampleRate);
+
+            if (auto* object = result.getDynamicObject())
+            {
+                const auto nsPerSample = (double)object->getProperty("nsPerSample");
+
+                if (method.name == "std::tanh")
+                    stdTanhNsPerSample = nsPerSample;
+
+                object->setProperty("method", method.name);
+                object->setProperty("curve", method.curve);
+                object->setProperty("blockSize", blockSize);
+                object->setProperty("doublePrecision", options.doublePrecision);
+                object->setProperty("maxAbsError", maxErrors[m]);
+                object->setProperty("speedupVsStdTanh", nsPerSample > 0.0 ? stdTanhNsPerSample / nsPerSample : 0.0);
+            }
+
+            results.add(result);
+        }
+    }
+
+    return results;
+}
+
+var runShaperSuite(const Options& options)
+{
+    return options.doublePrecision ? runShaperSweep<double>(options) : runShaperSweep<float>(options);
+}
+
+} // namespace bench
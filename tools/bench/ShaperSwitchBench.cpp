@@ -0,0 +1,84 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// The shaper type flipping between tanh and hard clip on every block with ADAA on, for
+// every ADAA order and oversampling choice. Each curve needs its own antiderivative
+// history, so a switch that carried one over would divide a step between the two curves'
+// antiderivatives by a small input difference: a slow sine driven 40 dB into the shapers
+// keeps those differences small, and its output has to stay within full scale.
+var runShaperSwitchSuite(const Options& options)
+{
+    constexpr auto driveDb = 40.0f;
+    constexpr auto signalHz = 50.0;
+    constexpr auto seconds = 0.5;
+
+    const PluginProcessor prototype;
+    const auto& choices = prototype.getParameterValues().processor2Group;
+    const std::array<int, 2> types{choices.type.choices.indexOf("Tanh"), choices.type.choices.indexOf("Hard clip")};
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        for (const auto sampleRate : options.sampleRates)
+        {
+            AudioBuffer<float> sine(numChannels, roundToInt(seconds * sampleRate));
+
+            for (auto channel = 0; channel < numChannels; ++channel)
+                for (auto i = 0; i < sine.getNumSamples(); ++i)
+                    sine.setSample(
+                        channel, i, 0.5f * (float)std::sin(MathConstants<double>::twoPi * signalHz * i / sampleRate)
+                    );
+
+            for (const auto blockSize : options.blockSizes)
+            {
+                for (auto order = 1; order < choices.antialiasing.choices.size(); ++order)
+                {
+                    for (auto oversampling = 0; oversampling < choices.oversampler.choices.size(); ++oversampling)
+                    {
+                        auto processor = createProcessor(numChannels, sampleRate, blockSize);
+                        const auto& state = processor->getParameterValues().processor2Group;
+                        state.type = types[0];
+                        state.antialiasing = order;
+                        state.oversampler = oversampling;
+                        state.inGain.setValueNotifyingHost(state.inGain.convertTo0to1(driveDb));
+                        processor->prepareToPlay(sampleRate, blockSize);
+
+                        AudioBuffer<float> output(sine);
+                        MidiBuffer midi;
+                        auto peak = 0.0f;
+                        auto numSwitches = 0;
+
+                        for (auto start = 0; start < output.getNumSamples(); start += blockSize)
+                        {
+                            state.type = types[(size_t)(++numSwitches % 2)];
+
+                            const auto length = jmin(blockSize, output.getNumSamples() - start);
+                            AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, start, length);
+                            processor->processBlock(block, midi);
+
+                            peak = jmax(peak, block.getMagnitude(0, length));
+                        }
+
+                        auto* result = new DynamicObject();
+                        result->setProperty("sampleRate", sampleRate);
+                        result->setProperty("blockSize", blockSize);
+                        result->setProperty("channels", numChannels);
+                        result->setProperty("processor2Antialiasing", order);
+                        result->setProperty("processor2Oversampler", oversampling);
+                        result->setProperty("switches", numSwitches);
+                        result->setProperty("peak", peak);
+                        result->setProperty("passed", std::isfinite(peak) && peak <= 1.0f);
+                        results.add(result);
+                    }
+                }
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,94 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// A large session loading and closing: constructs many instances, then prepares them, then
+// deletes them, and reports the time and resident memory per instance of each phase
+// separately. The first instance in the process is timed on its own, as it also builds the
+// resources all instances share.
+var runStartupSuite(const Options& options)
+{
+    const auto numInstances = options.getNumInstances(500);
+
+    Array<var> results;
+
+    for (const auto numChannels : options.channelCounts)
+    {
+        for (const auto sampleRate : options.sampleRates)
+        {
+            for (const auto blockSize : options.blockSizes)
+            {
+                std::vector<std::unique_ptr<PluginProcessor>> processors;
+                processors.reserve((size_t)numInstances);
+
+                const auto elapsedMs = [](int64 start)
+                { return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0; };
+
+                const auto residentBefore = getResidentBytes();
+                auto start = Time::getHighResolutionTicks();
+
+                processors.push_back(std::make_unique<PluginProcessor>());
+                const auto firstConstructMs = elapsedMs(start);
+
+                start = Time::getHighResolutionTicks();
+
+                for (auto i = 1; i < numInstances; ++i)
+                    processors.push_back(std::make_unique<PluginProcessor>());
+
+                const auto constructMs = elapsedMs(start);
+                const auto residentConstructed = getResidentBytes();
+
+                for (auto& processor : processors)
+                {
+                    processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+                    processor->setProcessingPrecision(
+                        options.doublePrecision ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision
+                    );
+                }
+
+                start = Time::getHighResolutionTicks();
+                processors.front()->prepareToPlay(sampleRate, blockSize);
+                const auto firstPrepareMs = elapsedMs(start);
+
+                start = Time::getHighResolutionTicks();
+
+                for (size_t i = 1; i < processors.size(); ++i)
+                    processors[i]->prepareToPlay(sampleRate, blockSize);
+
+                const auto prepareMs = elapsedMs(start);
+                const auto residentPrepared = getResidentBytes();
+
+                start = Time::getHighResolutionTicks();
+                processors.clear();
+                const auto destroyMs = elapsedMs(start);
+
+                const auto perInstance = [&](double value) { return value / numInstances; };
+                const auto perOtherInstance = [&](double value) { return value / jmax(1, numInstances - 1); };
+
+                auto* result = new DynamicObject();
+                result->setProperty("sampleRate", sampleRate);
+                result->setProperty("blockSize", blockSize);
+                result->setProperty("channels", numChannels);
+                result->setProperty("doublePrecision", options.doublePrecision);
+                result->setProperty("instances", numInstances);
+                result->setProperty("firstConstructMs", firstConstructMs);
+                result->setProperty("constructMsPerInstance", perOtherInstance(constructMs));
+                result->setProperty("firstPrepareMs", firstPrepareMs);
+                result->setProperty("prepareMsPerInstance", perOtherInstance(prepareMs));
+                result->setProperty("destroyMsPerInstance", perInstance(destroyMs));
+                result->setProperty(
+                    "residentBytesPerInstanceConstructed", perInstance((double)(residentConstructed - residentBefore))
+                );
+                result->setProperty(
+                    "residentBytesPerInstancePrepared", perInstance((double)(residentPrepared - residentBefore))
+                );
+                results.add(result);
+            }
+        }
+    }
+
+    return results;
+}
+
+} // namespace bench
@@ -0,0 +1,153 @@
+#include "Bench.h"
+
+namespace bench
+{
+//==============================================================================
+// What getStateInformation wrote before the binary format, on the same path: the APVTS tree
+// copied and converted to XML, then to JUCE's binary XML blob.
+static MemoryBlock createLegacyState(PluginProcessor& processor)
+{
+    MemoryBlock block;
+    AudioProcessor::copyXmlToBinary(*processor.getValueTreeState().copyState().createXml(), block);
+    return block;
+}
+
+// `state` as an older version saved it, with the shaper and the oversampling under their
+// legacy IDs.
+static MemoryBlock renameToLegacyIds(const MemoryBlock& state)
+{
+    const std::array<std::pair<const char*, const char*>, 2> renames{{
+        {ID::processor2Shaper, LegacyID::processor2Type},
+        {ID::processor2Oversampling, LegacyID::processor2Oversampler},
+    }};
+
+    if (auto entries = StateFormat::read(state.getData(), (int)state.getSize()))
+    {
+        for (auto& entry : *entries)
+            for (const auto& [id, legacyId] : renames)
+                if (entry.id == StateFormat::hashParameterId(id))
+                    entry.id = StateFormat::hashParameterId(legacyId);
+
+        MemoryBlock block;
+        StateFormat::write(block, *entries);
+        return block;
+    }
+
+    const auto xml = AudioProcessor::getXmlFromBinary(state.getData(), (int)state.getSize());
+
+    for (auto* param : xml->getChildWithTagNameIterator("PARAM"))
+        for (const auto& [id, legacyId] : renames)
+            if (param->getStringAttribute("id") == id)
+                param->setAttribute("id", legacyId);
+
+    MemoryBlock block;
+    AudioProcessor::copyXmlToBinary(*xml, block);
+    return block;
+}
+
+static bool hasSameValues(const PluginProcessor& a, const PluginProcessor& b)
+{
+    const auto& parametersA = a.getParameters();
+    const auto& parametersB = b.getParameters();
+
+    for (auto i = 0; i < parametersA.size(); ++i)
+        if (std::abs(parametersA[i]->getValue() - parametersB[i]->getValue()) > 1.0e-6f)
+            return false;
+
+    return true;
+}
+
+// Saves and loads the state of many instances with random settings, the way a session
+// does, in the binary format and from the legacy XML, and checks both round trips, also
+// with the shaper and the oversampling saved under their legacy IDs.
+var runStateSuite(const Options& options)
+{
+    const auto numInstances = options.getNumInstances(1000);
+
+    std::vector<std::unique_ptr<PluginProcessor>> sources, binaryTargets, legacyTargets;
+    Random random(42);
+
+    for (auto i = 0; i < numInstances; ++i)
+    {
+        sources.push_back(std::make_unique<PluginProcessor>());
+        binaryTargets.push_back(std::make_unique<PluginProcessor>());
+        legacyTargets.push_back(std::make_unique<PluginProcessor>());
+
+        sources.back()->getParameterValues().forEachParameter(
+            [&](RangedAudioParameter& param) { param.setValueNotifyingHost(random.nextFloat()); }
+        );
+    }
+
+    std::vector<MemoryBlock> binaryStates((size_t)numInstances), legacyStates((size_t)numInstances);
+
+    const auto time = [&](auto&& func)
+    {
+        const auto start = Time::getHighResolutionTicks();
+
+        for (size_t i = 0; i < (size_t)numInstances; ++i)
+            func(i);
+
+        return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1.0e6 / numInstances;
+    };
+
+    const auto binarySaveUs = time([&](size_t i) { sources[i]->getStateInformation(binaryStates[i]); });
+    const auto legacySaveUs = time([&](size_t i) { legacyStates[i] = createLegacyState(*sources[i]); });
+
+    const auto binaryLoadUs = time(
+        [&](size_t i)
+        { binaryTargets[i]->setStateInformation(binaryStates[i].getData(), (int)binaryStates[i].getSize()); }
+    );
+    const auto legacyLoadUs = time(
+        [&](size_t i)
+        { legacyTargets[i]->setStateInformation(legacyStates[i].getData(), (int)legacyStates[i].getSize()); }
+    );
+
+    auto binaryBytes = (size_t)0, legacyBytes = (size_t)0;
+    auto binaryRoundTrip = true, legacyRoundTrip = true;
+
+    for (size_t i = 0; i < (size_t)numInstances; ++i)
+    {
+        binaryBytes += binaryStates[i].getSize();
+        legacyBytes += legacyStates[i].getSize();
+        binaryRoundTrip = binaryRoundTrip && hasSameValues(*sources[i], *binaryTargets[i]);
+        legacyRoundTrip = legacyRoundTrip && hasSameValues(*sources[i], *legacyTargets[i]);
+    }
+
+    // older sessions, limited to the choices they had, which kept their indices
+    auto legacyIdRoundTrip = true;
+
+    for (size_t i = 0; i < jmin((size_t)numInstances, (size_t)16); ++i)
+    {
+        auto& shaper = sources[i]->getParameterValues().processor2Group.type;
+        auto& oversampler = sources[i]->getParameterValues().processor2Group.oversampler;
+        shaper.setValueNotifyingHost(shaper.convertTo0to1((float)(i % 2)));
+        oversampler.setValueNotifyingHost(oversampler.convertTo0to1((float)(i % 6)));
+
+        MemoryBlock binaryState;
+        sources[i]->getStateInformation(binaryState);
+
+        for (const auto& state : {binaryState, createLegacyState(*sources[i])})
+        {
+            const auto legacyState = renameToLegacyIds(state);
+            PluginProcessor target;
+            target.setStateInformation(legacyState.getData(), (int)legacyState.getSize());
+            legacyIdRoundTrip = legacyIdRoundTrip && hasSameValues(*sources[i], target);
+        }
+    }
+
+    auto* result = new DynamicObject();
+    result->setProperty("instances", numInstances);
+    result->setProperty("binaryBytesPerInstance", (double)binaryBytes / numInstances);
+    result->setProperty("legacyXmlBytesPerInstance", (double)legacyBytes / numInstances);
+    result->setProperty("binarySaveUsPerInstance", binarySaveUs);
+    result->setProperty("legacyXmlSaveUsPerInstance", legacySaveUs);
+    result->setProperty("binaryLoadUsPerInstance", binaryLoadUs);
+    result->setProperty("legacyXmlLoadUsPerInstance", legacyLoadUs);
+    result->setProperty("binaryRoundTrip", binaryRoundTrip);
+    result->setProperty("legacyXmlRoundTrip", legacyRoundTrip);
+    result->setProperty("legacyIdRoundTrip", legacyIdRoundTrip);
+
+    return Array<var>{var(result)};
+}
+
+} // namespace bench
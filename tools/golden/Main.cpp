@@ -0,0 +1,408 @@
+#include <JuceHeader.h>
+
+#include "PluginProcessor.h"
+
+#include <bit>
+
+//==============================================================================
+// Golden-output regression check for PluginProcessor.
+//
+// usage: myPluginGolden [--record] [--references=<dir>] [--mode=exact|ulp|snr] [--tolerance=<ulps or dB>]
+//                       [--block-sizes=64,441] [--threads=<count>]
+//
+// Renders fixed test signals (a log sweep, noise and an impulse train) through every
+// waveshaper type, oversampling choice and block size, and compares each render with the
+// reference WAV of the same case. The anti-aliasing orders and linear interpolation are
+// rendered for every type too, at 2x and 1x. --record writes the references instead. ctest
+// records them first with this tool as built from a pinned commit (MY_GOLDEN_BASELINE in
+// tools/CMakeLists.txt), then runs the check. Exits with 1 if any case is missing or out of
+// tolerance, and when there are no references at all.
+//
+// exact: every sample bit-identical
+// ulp:   no sample more than --tolerance (default 4) float steps away from the reference
+// snr:   reference power over error power of at least --tolerance (default 120) dB
+//
+// Cases render in parallel, each with its own processor.
+namespace
+{
+constexpr auto sampleRate = 48000.0;
+constexpr auto numChannels = 2;
+constexpr auto numSamples = 12000; // 0.25 s
+
+//==============================================================================
+// Deterministic stereo test signals; the right channel is scaled so swapped channels show.
+AudioBuffer<float> createSignal(const String& name)
+{
+    AudioBuffer<float> signal(numChannels, numSamples);
+    signal.clear();
+
+    for (auto channel = 0; channel < numChannels; ++channel)
+    {
+        const auto gain = channel == 0 ? 1.0f : 0.5f;
+        auto* data = signal.getWritePointer(channel);
+
+        if (name == "sweep")
+        {
+            // 20 Hz to 20 kHz, exponential
+            constexpr auto f0 = 20.0, f1 = 20000.0;
+            const auto duration = numSamples / sampleRate;
+            const auto k = std::log(f1 / f0);
+
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                const auto t = i / sampleRate;
+                const auto phase = MathConstants<double>::twoPi * f0 * duration / k
+                                 * (std::exp(t / duration * k) - 1.0);
+                data[i] = gain * 0.5f * (float)std::sin(phase);
+            }
+        }
+        else if (name == "noise")
+        {
+            Random random(4321 + channel);
+
+            for (auto i = 0; i < numSamples; ++i)
+                data[i] = gain * 0.5f * (random.nextFloat() * 2.0f - 1.0f);
+        }
+        else if (name == "impulses")
+        {
+            for (auto i = 0; i < numSamples; i += numSamples / 8)
+                data[i] = gain;
+        }
+    }
+
+    return signal;
+}
+
+const StringArray signalNames{"sweep", "noise", "impulses"};
+
+//==============================================================================
+struct Case
+{
+    String signal;
+    int type;
+    int oversampling;
+    int blockSize;
+    int antialiasing = 0;
+    int interpolation = 1; // cubic, the default
+
+    // cases with the default anti-aliasing and interpolation keep their original names
+    String getName() const
+    {
+        return signal + "_type" + String(type) + "_os" + String(oversampling) + "_block" + String(blockSize)
+             + (antialiasing != 0 ? "_adaa" + String(antialiasing) : String())
+             + (interpolation != 1 ? "_interp" + String(interpolation) : String());
+    }
+};
+
+// Renders one case the way an offline bounce would, with the shaper driven into saturation.
+AudioBuffer<float> render(const Case& c, const AudioBuffer<float>& input)
+{
+    PluginProcessor processor;
+    processor.setNonRealtime(true);
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, c.blockSize);
+
+    const auto& state = processor.getParameterValues().processor2Group;
+    state.enabled = true;
+    state.type = c.type;
+    state.oversampler = c.oversampling;
+    state.antialiasing = c.antialiasing;
+    state.interpolation = c.interpolation;
+    state.inGain.setValueNotifyingHost(state.inGain.convertTo0to1(12.0f));
+
+    processor.prepareToPlay(sampleRate, c.blockSize);
+
+    AudioBuffer<float> output(input);
+    MidiBuffer midi;
+
+    for (auto start = 0; start < numSamples; start += c.blockSize)
+    {
+        const auto length = jmin(c.blockSize, numSamples - start);
+        AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, start, length);
+        processor.processBlock(block, midi);
+    }
+
+    processor.releaseResources();
+    return output;
+}
+
+//==============================================================================
+bool writeWav(const File& file, const AudioBuffer<float>& buffer)
+{
+    file.deleteFile();
+
+    auto stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return false;
+
+    // 32-bit float, so the references hold exactly what was rendered
+    std::unique_ptr<AudioFormatWriter> writer(
+        WavAudioFormat().createWriterFor(stream.get(), sampleRate, (unsigned int)buffer.getNumChannels(), 32, {}, 0)
+    );
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // owned by the writer now
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+std::optional<AudioBuffer<float>> readWav(const File& file)
+{
+    if (!file.existsAsFile())
+        return std::nullopt;
+
+    std::unique_ptr<AudioFormatReader> reader(
+        WavAudioFormat().createReaderFor(file.createInputStream().release(), true)
+    );
+
+    if (reader == nullptr || !reader->usesFloatingPointData || reader->bitsPerSample != 32)
+        return std::nullopt;
+
+    AudioBuffer<float> buffer((int)reader->numChannels, (int)reader->lengthInSamples);
+
+    if (!reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true))
+        return std::nullopt;
+
+    return buffer;
+}
+
+//==============================================================================
+enum class Mode
+{
+    exact,
+    ulp,
+    snr
+};
+
+struct Comparison
+{
+    bool sameShape = false;
+    int64 differentSamples = 0;
+    int64 maxUlps = 0;
+    double snrDb = 0.0; // infinite when identical
+
+    bool passes(Mode mode, double tolerance) const
+    {
+        if (!sameShape)
+            return false;
+
+        switch (mode)
+        {
+            case Mode::exact:
+                return differentSamples == 0;
+            case Mode::ulp:
+                return (double)maxUlps <= tolerance;
+            case Mode::snr:
+                return snrDb >= tolerance;
+        }
+
+        return false;
+    }
+};
+
+// Distance in representable floats; +0 and -0 are the same, NaNs are infinitely far.
+int64 getUlps(float a, float b)
+{
+    if (std::isnan(a) || std::isnan(b))
+        return std::numeric_limits<int64>::max();
+
+    const auto toOrdered = [](float x)
+    {
+        const auto bits = (int64)std::bit_cast<int32>(x);
+        return bits >= 0 ? bits : (int64)std::numeric_limits<int32>::min() - bits;
+    };
+
+    return std::abs(toOrdered(a) - toOrdered(b));
+}
+
+Comparison compare(const AudioBuffer<float>& output, const AudioBuffer<float>& reference)
+{
+    Comparison result;
+    result.sameShape = output.getNumChannels() == reference.getNumChannels()
+                    && output.getNumSamples() == reference.getNumSamples();
+
+    if (!result.sameShape)
+        return result;
+
+    auto signalPower = 0.0, errorPower = 0.0;
+
+    for (auto channel = 0; channel < output.getNumChannels(); ++channel)
+    {
+        const auto* out = output.getReadPointer(channel);
+        const auto* ref = reference.getReadPointer(channel);
+
+        for (auto i = 0; i < output.getNumSamples(); ++i)
+        {
+            if (std::bit_cast<uint32>(out[i]) != std::bit_cast<uint32>(ref[i]))
+                ++result.differentSamples;
+
+            result.maxUlps = jmax(result.maxUlps, getUlps(out[i], ref[i]));
+
+            const auto error = (double)out[i] - (double)ref[i];
+            signalPower += (double)ref[i] * (double)ref[i];
+            errorPower += error * error;
+        }
+    }
+
+    result.snrDb = errorPower > 0.0 ? 10.0 * std::log10(signalPower / errorPower)
+                                    : std::numeric_limits<double>::infinity();
+    return result;
+}
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+    const ArgumentList args(argc, argv);
+
+    const auto record = args.containsOption("--record");
+    const auto references = args.containsOption("--references") ? args.getFileForOption("--references")
+                                                                : File(MY_GOLDEN_REFERENCE_DIR);
+
+    const std::map<String, std::pair<Mode, double>> modes{
+        {"exact", {Mode::exact, 0.0}},
+        {"ulp", {Mode::ulp, 4.0}},
+        {"snr", {Mode::snr, 120.0}},
+    };
+
+    const auto modeName = args.containsOption("--mode") ? args.getValueForOption("--mode") : String("exact");
+    const auto mode = modes.find(modeName);
+
+    if (mode == modes.end())
+    {
+        std::cerr << "unknown mode: " << modeName << std::endl;
+        return 1;
+    }
+
+    const auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getDoubleValue()
+                                                              : mode->second.second;
+
+    Array<int> blockSizes{64, 441};
+
+    if (args.containsOption("--block-sizes"))
+    {
+        blockSizes.clear();
+
+        for (const auto& token : StringArray::fromTokens(args.getValueForOption("--block-sizes"), ",", ""))
+            blockSizes.add(jmax(1, token.getIntValue()));
+    }
+
+    if (record && !references.createDirectory().wasOk())
+    {
+        std::cerr << "cannot create " << references.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // the choice lists come from the processor, so new types and factors are covered too
+    std::vector<Case> cases;
+
+    {
+        const PluginProcessor prototype;
+        const auto& state = prototype.getParameterValues().processor2Group;
+
+        jassert(state.antialiasing.getIndex() == 0 && state.interpolation.getIndex() == 1);
+
+        for (const auto& signal : signalNames)
+            for (auto type = 0; type < state.type.choices.size(); ++type)
+                for (auto oversampling = 0; oversampling < state.oversampler.choices.size(); ++oversampling)
+                    for (const auto blockSize : blockSizes)
+                        cases.push_back({signal, type, oversampling, blockSize});
+
+        // the shapers without ADAA or tables ignore these, which is worth covering as well
+        const auto oneX = state.oversampler.choices.size() - 1;
+
+        for (const auto& signal : signalNames)
+        {
+            for (auto type = 0; type < state.type.choices.size(); ++type)
+            {
+                for (const auto oversampling : {0, oneX})
+                {
+                    for (const auto blockSize : blockSizes)
+                    {
+                        for (auto order = 1; order < state.antialiasing.choices.size(); ++order)
+                            cases.push_back({signal, type, oversampling, blockSize, order});
+
+                        cases.push_back({signal, type, oversampling, blockSize, 0, 0});
+                    }
+                }
+            }
+        }
+    }
+
+    // nothing to compare with is a failure, not a pass
+    if (!record && references.findChildFiles(File::findFiles, false, "*.wav").isEmpty())
+    {
+        std::cerr << "no references in " << references.getFullPathName()
+                  << ", record them with --record or run ctest, which records the pinned baseline's" << std::endl;
+        return 1;
+    }
+
+    std::map<String, AudioBuffer<float>> signals;
+
+    for (const auto& signal : signalNames)
+        signals.emplace(signal, createSignal(signal));
+
+    // one line of the report per case, filled in by the jobs
+    std::vector<String> lines(cases.size());
+    std::atomic<int> failures{0}, remaining{(int)cases.size()};
+    WaitableEvent finished;
+
+    const auto numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                             : SystemStats::getNumCpus();
+    ThreadPool pool(jmax(1, numThreads));
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        pool.addJob(
+            [&, i]
+            {
+                const auto& c = cases[i];
+                const auto file = references.getChildFile(c.getName() + ".wav");
+                const auto output = render(c, signals.at(c.signal));
+
+                if (record)
+                {
+                    const auto written = writeWav(file, output);
+                    lines[i] = (written ? "recorded " : "FAILED   ") + c.getName();
+
+                    if (!written)
+                        ++failures;
+                }
+                else if (const auto reference = readWav(file))
+                {
+                    const auto comparison = compare(output, *reference);
+                    const auto passed = comparison.passes(mode->second.first, tolerance);
+
+                    lines[i] = (passed ? "ok       " : "FAILED   ") + c.getName()
+                             + (comparison.sameShape ? "  differing samples " + String(comparison.differentSamples)
+                                                           + ", max ulps " + String(comparison.maxUlps) + ", snr "
+                                                           + String(comparison.snrDb, 1) + " dB"
+                                                     : String("  length or channel count differs"));
+
+                    if (!passed)
+                        ++failures;
+                }
+                else
+                {
+                    lines[i] = "MISSING  " + c.getName() + "  no readable reference, run with --record";
+                    ++failures;
+                }
+
+                if (--remaining == 0)
+                    finished.signal();
+            }
+        );
+    }
+
+    finished.wait();
+
+    for (const auto& line : lines)
+        std::cout << line << std::endl;
+
+    std::cout << cases.size() << " case(s), " << failures.load() << " failed"
+              << (record ? String() : " (" + modeName + ", tolerance " + String(tolerance) + ")") << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,498 @@
+#include <JuceHeader.h>
+
+#include "PluginProcessor.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/resource.h>
+#endif
+
+//==============================================================================
+// Batch renderer: runs audio files through PluginProcessor with fixed settings.
+//
+// usage: myPluginRender --state=<file> --output=<dir> [--jobs=<count>] [--block-size=<samples>]
+//                       [--tail=<seconds>] [--high-quality] [--no-mmap] <file>...
+//
+// --state is a blob as written by getStateInformation, e.g. saved from a session. Every
+// input file is rendered by its own processor, several at once (--jobs, all cores by
+// default), and written as a WAV of the same name and bit depth into --output; inputs that
+// would land in the same file, e.g. a.wav and a.aiff, are refused. The output is trimmed by
+// the reported latency and runs on past the end of the input by the processor's tail plus
+// --tail, so it lines up with the input sample for sample. A failed render deletes its
+// output rather than leaving a truncated file.
+//
+// WAV and AIFF inputs are read through a sliding memory-mapped window, other formats (and
+// all of them with --no-mmap) chunk by chunk on an I/O pool while the previous chunk is
+// processed. Written chunks queue up for a shared writer thread. Either way memory use is
+// fixed by the block size, not the file length, and each file reports its throughput in
+// MB of input per second.
+namespace
+{
+struct Chunk
+{
+    AudioBuffer<float> buffer;
+    int length = 0; // 0 past the end of the file
+};
+
+//==============================================================================
+// Double buffered reading: while the caller processes one chunk, the next one is read
+// into the other buffer on the I/O pool.
+class ReadAhead
+{
+  public:
+    ReadAhead(AudioFormatReader& readerIn, ThreadPool& poolIn, int chunkSize)
+        : reader(readerIn)
+        , pool(poolIn)
+    {
+        for (auto& chunk : chunks)
+            chunk.buffer.setSize((int)reader.numChannels, chunkSize);
+
+        startReading(chunks[0]);
+    }
+
+    ~ReadAhead()
+    {
+        // the job writes into our buffers
+        if (reading)
+            done.wait();
+    }
+
+    // Waits for the chunk being read, starts reading the one after it and returns it.
+    // Valid until the next call.
+    Chunk& next()
+    {
+        done.wait();
+        reading = false;
+
+        auto& ready = chunks[current];
+        current ^= 1;
+
+        if (ready.length > 0)
+            startReading(chunks[current]);
+
+        return ready;
+    }
+
+    bool hasFailed() const
+    {
+        return failed;
+    }
+
+  private:
+    void startReading(Chunk& chunk)
+    {
+        reading = true;
+
+        pool.addJob(
+            [this, &chunk]
+            {
+                chunk.length = (int)jmin((int64)chunk.buffer.getNumSamples(), reader.lengthInSamples - position);
+
+                if (chunk.length > 0 && !reader.read(&chunk.buffer, 0, chunk.length, position, true, true))
+                {
+                    failed = true;
+                    chunk.length = 0;
+                }
+
+                position += chunk.length;
+                done.signal();
+            }
+        );
+    }
+
+    AudioFormatReader& reader;
+    ThreadPool& pool;
+    std::array<Chunk, 2> chunks;
+    size_t current = 0;
+    int64 position = 0; // only touched by the read jobs, one at a time
+    bool reading = false;
+    std::atomic<bool> failed{false};
+    WaitableEvent done;
+};
+
+// Reads straight from a memory-mapped WAV or AIFF: each chunk is converted from the mapped
+// pages into the processing buffer in one go, without read calls or a second buffer, and
+// the kernel's readahead overlaps the disk with the processing. Only a window of the file is
+// mapped at a time, so the pages of a multi-hour file don't pile up in memory.
+class MappedSource
+{
+  public:
+    static constexpr int64 windowSize = 1 << 20; // samples per channel
+
+    MappedSource(MemoryMappedAudioFormatReader& readerIn, int chunkSize)
+        : reader(readerIn)
+    {
+        chunk.buffer.setSize((int)reader.numChannels, chunkSize);
+    }
+
+    // Valid until the next call.
+    Chunk& next()
+    {
+        chunk.length = (int)jmin((int64)chunk.buffer.getNumSamples(), reader.lengthInSamples - position);
+
+        if (chunk.length <= 0)
+            return chunk;
+
+        const Range<int64> range(position, position + chunk.length);
+
+        // moving the window unmaps the part already processed
+        if (!reader.getMappedSection().contains(range)
+            && !reader.mapSectionOfFile({position, jmin(reader.lengthInSamples, position + windowSize)}))
+        {
+            failed = true;
+            chunk.length = 0;
+            return chunk;
+        }
+
+        if (!reader.read(&chunk.buffer, 0, chunk.length, position, true, true))
+        {
+            failed = true;
+            chunk.length = 0;
+        }
+
+        position += chunk.length;
+        return chunk;
+    }
+
+    bool hasFailed() const
+    {
+        return failed;
+    }
+
+  private:
+    MemoryMappedAudioFormatReader& reader;
+    Chunk chunk;
+    int64 position = 0;
+    bool failed = false;
+};
+
+// A mapped reader for formats that support it (WAV and AIFF), nullptr for the rest.
+std::unique_ptr<MemoryMappedAudioFormatReader> createMappedReader(AudioFormatManager& formats, const File& input)
+{
+    auto* format = formats.findFormatForFileExtension(input.getFileExtension());
+
+    if (format == nullptr)
+        return nullptr;
+
+    std::unique_ptr<MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(input));
+
+    // e.g. compressed WAVs can't be read from the mapped data
+    if (reader == nullptr || !reader->mapSectionOfFile({0, jmin(reader->lengthInSamples, MappedSource::windowSize)}))
+        return nullptr;
+
+    return reader;
+}
+
+//==============================================================================
+struct Settings
+{
+    MemoryBlock state;
+    File outputDirectory;
+    int blockSize = 4096;
+    double extraTailSeconds = 0.0;
+    bool highQuality = false;
+    bool memoryMapping = true;
+};
+
+// Where `input` is rendered to.
+File getOutputFile(const File& input, const Settings& settings)
+{
+    return settings.outputDirectory.getChildFile(input.getFileNameWithoutExtension() + ".wav");
+}
+
+// Deletes the file when it goes out of scope, unless it was kept.
+class PartialFile
+{
+  public:
+    explicit PartialFile(const File& fileIn)
+        : file(fileIn)
+    {
+    }
+
+    ~PartialFile()
+    {
+        if (!kept)
+            file.deleteFile();
+    }
+
+    void keep()
+    {
+        kept = true;
+    }
+
+  private:
+    File file;
+    bool kept = false;
+};
+
+// What one render reports back.
+struct Outcome
+{
+    bool ok = false;
+    String message;
+    int64 inputBytes = 0;
+};
+
+Outcome render(const File& input, const Settings& settings, ThreadPool& ioPool, TimeSliceThread& writerThread)
+{
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    const auto start = Time::getHighResolutionTicks();
+
+    const auto mapped = settings.memoryMapping ? createMappedReader(formats, input) : nullptr;
+    const std::unique_ptr<AudioFormatReader> buffered(mapped == nullptr ? formats.createReaderFor(input) : nullptr);
+    auto* reader = mapped != nullptr ? mapped.get() : buffered.get();
+
+    if (reader == nullptr)
+        return {false, "cannot read " + input.getFullPathName()};
+
+    const auto output = getOutputFile(input, settings);
+
+    if (output == input)
+        return {false, "would overwrite " + input.getFullPathName()};
+
+    const auto numChannels = (int)reader->numChannels;
+    const auto sampleRate = reader->sampleRate;
+    const auto blockSize = settings.blockSize;
+
+    // set up like a host's offline bounce, with the stored settings; --high-quality overrides
+    // the state's "Offline quality", which would otherwise reset it
+    PluginProcessor processor;
+    processor.setNonRealtime(true);
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.setStateInformation(settings.state.getData(), (int)settings.state.getSize());
+
+    if (settings.highQuality)
+        processor.setOfflineHighQuality(true);
+
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    const auto latency = processor.getLatencySamples();
+    const auto tail = roundToInt((processor.getTailLengthSeconds() + settings.extraTailSeconds) * sampleRate);
+
+    output.deleteFile();
+
+    // declared first so the writer has closed the file before it goes
+    PartialFile partialOutput(output);
+    auto stream = output.createOutputStream();
+
+    if (stream == nullptr)
+        return {false, "cannot write " + output.getFullPathName()};
+
+    const auto bitsPerSample = reader->usesFloatingPointData ? 32 : jlimit(16, 24, (int)reader->bitsPerSample);
+    std::unique_ptr<AudioFormatWriter> writer(
+        WavAudioFormat().createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, bitsPerSample, {}, 0)
+    );
+
+    if (writer == nullptr)
+        return {false, "cannot write " + output.getFullPathName()};
+
+    stream.release(); // owned by the writer now
+
+    // flushes whatever is still queued when it goes out of scope
+    AudioFormatWriter::ThreadedWriter threadedWriter(writer.release(), writerThread, blockSize * 8);
+
+    // skips the first `latency` output samples, then passes exactly input length + tail on
+    auto toSkip = (int64)latency;
+    auto toWrite = reader->lengthInSamples + tail;
+    std::vector<const float*> channels((size_t)numChannels);
+
+    const auto write = [&](const AudioBuffer<float>& buffer, int length)
+    {
+        const auto skipped = (int)jmin((int64)length, toSkip);
+        const auto written = (int)jmin((int64)(length - skipped), toWrite);
+
+        toSkip -= skipped;
+        toWrite -= written;
+
+        for (auto channel = 0; channel < numChannels; ++channel)
+            channels[(size_t)channel] = buffer.getReadPointer(channel, skipped);
+
+        // the queue is full while the disk catches up
+        while (written > 0 && !threadedWriter.write(channels.data(), written))
+            Thread::sleep(1);
+    };
+
+    MidiBuffer midi;
+
+    const auto processAll = [&](auto& source)
+    {
+        for (auto* chunk = &source.next(); chunk->length > 0; chunk = &source.next())
+        {
+            AudioBuffer<float> block(chunk->buffer.getArrayOfWritePointers(), numChannels, 0, chunk->length);
+            processor.processBlock(block, midi);
+            write(block, chunk->length);
+        }
+
+        return !source.hasFailed();
+    };
+
+    if (mapped != nullptr)
+    {
+        MappedSource source(*mapped, blockSize);
+
+        if (!processAll(source))
+            return {false, "read error in " + input.getFullPathName()};
+    }
+    else
+    {
+        ReadAhead source(*reader, ioPool, blockSize);
+
+        if (!processAll(source))
+            return {false, "read error in " + input.getFullPathName()};
+    }
+
+    // flush the latency and the tail out with silence
+    AudioBuffer<float> silence(numChannels, blockSize);
+
+    while (toWrite > 0)
+    {
+        silence.clear();
+        processor.processBlock(silence, midi);
+        write(silence, blockSize);
+    }
+
+    processor.releaseResources();
+    partialOutput.keep();
+
+    const auto seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+    const auto inputBytes = input.getSize();
+    const auto throughput = String((double)inputBytes / 1.0e6 / jmax(seconds, 1.0e-6), 1) + " MB/s";
+    const auto source = mapped != nullptr ? "mapped" : "buffered";
+
+    const auto message = input.getFileName() + " -> " + output.getFullPathName() + "  " + source + ", " + throughput;
+
+    return {true, message, inputBytes};
+}
+
+// Peak resident memory of this process, 0 where we don't know how to read it.
+int64 getPeakResidentBytes()
+{
+   #if JUCE_LINUX || JUCE_MAC
+    rusage usage{};
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    #if JUCE_MAC
+    return (int64)usage.ru_maxrss; // bytes
+    #else
+    return (int64)usage.ru_maxrss * 1024; // kilobytes
+    #endif
+   #else
+    return 0;
+   #endif
+}
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+    const ArgumentList args(argc, argv);
+
+    Settings settings;
+
+    if (!args.containsOption("--state") || !args.getFileForOption("--state").loadFileAsData(settings.state))
+    {
+        std::cerr << "--state=<file> with a saved plugin state is required" << std::endl;
+        return 1;
+    }
+
+    settings.outputDirectory = args.getFileForOption("--output");
+
+    if (!args.containsOption("--output") || !settings.outputDirectory.createDirectory().wasOk())
+    {
+        std::cerr << "--output=<dir> must be a writable directory" << std::endl;
+        return 1;
+    }
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = jmax(16, args.getValueForOption("--block-size").getIntValue());
+
+    if (args.containsOption("--tail"))
+        settings.extraTailSeconds = jmax(0.0, args.getValueForOption("--tail").getDoubleValue());
+
+    settings.highQuality = args.containsOption("--high-quality");
+    settings.memoryMapping = !args.containsOption("--no-mmap");
+
+    Array<File> inputs;
+
+    for (const auto& argument : args.arguments)
+        if (!argument.isOption())
+            inputs.add(argument.resolveAsFile());
+
+    if (inputs.isEmpty())
+    {
+        std::cerr << "no input files" << std::endl;
+        return 1;
+    }
+
+    // checked up front, as the renders run in parallel and would overwrite each other
+    std::map<File, File> outputs;
+
+    for (const auto& input : inputs)
+    {
+        if (const auto [existing, added] = outputs.emplace(getOutputFile(input, settings), input); !added)
+        {
+            std::cerr << existing->second.getFullPathName() << " and " << input.getFullPathName()
+                      << " would both be rendered to " << existing->first.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    const auto numJobs = args.containsOption("--jobs") ? args.getValueForOption("--jobs").getIntValue()
+                                                       : SystemStats::getNumCpus();
+
+    // reads are short and mostly wait on the disk, so a few threads serve all renders
+    ThreadPool ioPool(2);
+    TimeSliceThread writerThread("Render writer");
+    writerThread.startThread();
+
+    std::vector<Outcome> outcomes((size_t)inputs.size());
+    std::atomic<int> remaining{inputs.size()};
+    WaitableEvent finished;
+
+    const auto start = Time::getHighResolutionTicks();
+
+    {
+        ThreadPool renderPool(jmax(1, numJobs));
+
+        for (auto i = 0; i < inputs.size(); ++i)
+        {
+            renderPool.addJob(
+                [&, i]
+                {
+                    outcomes[(size_t)i] = render(inputs[i], settings, ioPool, writerThread);
+
+                    if (--remaining == 0)
+                        finished.signal();
+                }
+            );
+        }
+
+        finished.wait();
+    }
+
+    writerThread.stopThread(5000);
+
+    const auto seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+    auto failures = 0;
+    auto totalBytes = (int64)0;
+
+    for (const auto& outcome : outcomes)
+    {
+        std::cout << (outcome.ok ? "ok      " : "FAILED  ") << outcome.message << std::endl;
+
+        if (!outcome.ok)
+            ++failures;
+
+        totalBytes += outcome.inputBytes;
+    }
+
+    std::cout << outcomes.size() << " file(s), " << failures << " failed, "
+              << String((double)totalBytes / 1.0e6 / jmax(seconds, 1.0e-6), 1) << " MB/s overall, peak resident "
+              << String((double)getPeakResidentBytes() / 1.0e6, 1) << " MB" << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <JuceHeader.h>
+
+#include "PluginProcessor.h"
+#include "RealtimeCheck.h"
+
+//==============================================================================
+// Real-time safety check for PluginProcessor.
+//
+// usage: myPluginRtCheck [--seconds=<per case>]
+//
+// Drives the processor from this thread, as fast as it goes, through both precisions,
+// serial and parallel channel groups, odd block sizes, random automation of every
+// parameter and open meters. Exits with 1 and prints the call stacks if anything inside
+// processBlock, on the calling thread or a worker, allocated, freed or locked a mutex.
+//
+// The processor stays in realtime mode: offline renders build oversamplers in place on
+// purpose, see Processor2::setOversamplingIndex.
+namespace
+{
+struct Case
+{
+    bool doublePrecision;
+    int numChannels;
+    int maxChannelGroups;
+    int blockSize;
+};
+
+template <typename SampleType>
+void run(const Case& c, double seconds)
+{
+    constexpr auto sampleRate = 48000.0;
+
+    PluginProcessor processor;
+    processor.setMaxChannelGroups(c.maxChannelGroups);
+    processor.setPlayConfigDetails(c.numChannels, c.numChannels, sampleRate, c.blockSize);
+    processor.setProcessingPrecision(
+        c.doublePrecision ? AudioProcessor::doublePrecision : AudioProcessor::singlePrecision
+    );
+    processor.prepareToPlay(sampleRate, c.blockSize);
+    processor.setTelemetryEnabled(true);
+
+    AudioBuffer<SampleType> buffer(c.numChannels, c.blockSize);
+    MidiBuffer midi;
+    Random random(c.blockSize * 31 + c.numChannels);
+
+    const auto& parameters = processor.getParameters();
+    const auto numBlocks = roundToInt(seconds * sampleRate / c.blockSize);
+
+    for (auto block = 0; block < numBlocks; ++block)
+    {
+        // the host's side: automation and the editor draining the meters
+        if (block % 4 == 0)
+        {
+            auto* param = parameters[random.nextInt(parameters.size())];
+            param->setValueNotifyingHost(random.nextFloat());
+        }
+
+        processor.getTelemetry().popAll([](const Telemetry::Frame&) {});
+
+        for (auto channel = 0; channel < c.numChannels; ++channel)
+            for (auto i = 0; i < c.blockSize; ++i)
+                buffer.setSample(channel, i, (SampleType)(random.nextFloat() * 2.0f - 1.0f));
+
+        processor.processBlock(buffer, midi);
+    }
+
+    processor.releaseResources();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+    const ArgumentList args(argc, argv);
+
+    RealtimeCheck::install();
+
+    const auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+
+    // channels and channel groups
+    constexpr std::array<std::pair<int, int>, 3> layouts{
+        {{1, 1}, {2, 1}, {8, 4}}
+    };
+
+    for (const auto doublePrecision : {false, true})
+    {
+        for (const auto& [numChannels, maxChannelGroups] : layouts)
+        {
+            for (const auto blockSize : {64, 441})
+            {
+                const Case c{doublePrecision, numChannels, maxChannelGroups, blockSize};
+
+                if (doublePrecision)
+                    run<double>(c, seconds);
+                else
+                    run<float>(c, seconds);
+            }
+        }
+    }
+
+    const auto numViolations = RealtimeCheck::printViolations(std::cout);
+    std::cout << numViolations << " distinct real-time violation(s)" << std::endl;
+
+    return numViolations == 0 ? 0 : 1;
+}
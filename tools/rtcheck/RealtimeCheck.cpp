@@ -0,0 +1,311 @@
+#include <JuceHeader.h>
+
+#include "RealtimeCheck.h"
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+//==============================================================================
+// The hooks behind MY_REALTIME_SCOPE: global operator new and delete everywhere, and with
+// glibc also malloc and friends, free and pthread_mutex_lock, which is what std::mutex and
+// CriticalSection end up in. A call made by a thread inside a scope is recorded with its
+// call stack; repeats of the same stack are only counted.
+namespace
+{
+// plain zero-initialised thread_locals, safe to touch from inside malloc
+thread_local int realtimeDepth = 0;
+thread_local int suppressDepth = 0; // inside the checker, or below a hook that already checked
+
+struct ScopedSuppress
+{
+    ScopedSuppress() noexcept
+    {
+        ++suppressDepth;
+    }
+
+    ~ScopedSuppress() noexcept
+    {
+        --suppressDepth;
+    }
+};
+
+struct Violations
+{
+    SpinLock lock;
+    std::map<std::pair<String, String>, int> hits; // (call, stack)
+};
+
+Violations& getViolations()
+{
+    static Violations violations;
+    return violations;
+}
+
+void check(const char* call)
+{
+    if (realtimeDepth == 0 || suppressDepth > 0)
+        return;
+
+    const ScopedSuppress suppress;
+    const auto stack = SystemStats::getStackBacktrace();
+
+    auto& violations = getViolations();
+    const SpinLock::ScopedLockType lock(violations.lock);
+    ++violations.hits[{String(call), stack}];
+}
+
+void* allocate(std::size_t size, const char* call)
+{
+    check(call);
+
+    const ScopedSuppress suppress;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment, const char* call)
+{
+    check(call);
+
+    const ScopedSuppress suppress;
+    const auto align = jmax(sizeof(void*), (std::size_t)alignment);
+
+   #if JUCE_WINDOWS
+    return _aligned_malloc(size == 0 ? 1 : size, align);
+   #else
+    void* result = nullptr;
+    return posix_memalign(&result, align, size == 0 ? 1 : size) == 0 ? result : nullptr;
+   #endif
+}
+
+void deallocate(void* ptr, const char* call) noexcept
+{
+    if (ptr == nullptr)
+        return;
+
+    check(call);
+
+    const ScopedSuppress suppress;
+    std::free(ptr);
+}
+
+void deallocateAligned(void* ptr, const char* call) noexcept
+{
+    if (ptr == nullptr)
+        return;
+
+    check(call);
+
+    const ScopedSuppress suppress;
+
+   #if JUCE_WINDOWS
+    _aligned_free(ptr);
+   #else
+    std::free(ptr);
+   #endif
+}
+} // namespace
+
+//==============================================================================
+namespace RealtimeCheck
+{
+void enterScope() noexcept
+{
+    ++realtimeDepth;
+}
+
+void exitScope() noexcept
+{
+    --realtimeDepth;
+}
+
+void enterExemption() noexcept
+{
+    ++suppressDepth;
+}
+
+void exitExemption() noexcept
+{
+    --suppressDepth;
+}
+
+void install()
+{
+    // the first backtrace loads the unwinder, which allocates
+    ignoreUnused(SystemStats::getStackBacktrace());
+    ignoreUnused(getViolations());
+}
+
+int printViolations(std::ostream& out)
+{
+    const ScopedSuppress suppress;
+
+    auto& violations = getViolations();
+    const SpinLock::ScopedLockType lock(violations.lock);
+
+    for (const auto& [site, count] : violations.hits)
+    {
+        out << site.first << " inside processBlock, " << count << " time(s):" << std::endl;
+        out << site.second << std::endl;
+    }
+
+    return (int)violations.hits.size();
+}
+} // namespace RealtimeCheck
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+    if (auto* ptr = allocate(size, "operator new"))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (auto* ptr = allocate(size, "operator new[]"))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, "operator new");
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, "operator new[]");
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, "operator new"))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, "operator new[]"))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    deallocate(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    deallocateAligned(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    deallocateAligned(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocateAligned(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocateAligned(ptr, "operator delete[]");
+}
+
+//==============================================================================
+// glibc lets the executable replace its allocator; the originals stay reachable under
+// their __libc_ names.
+#if defined(__GLIBC__)
+extern "C"
+{
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void __libc_free(void*);
+
+void* malloc(std::size_t size) noexcept
+{
+    check("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+    check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+    check("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, std::size_t alignment, std::size_t size) noexcept
+{
+    check("posix_memalign");
+    *result = __libc_memalign(alignment, size);
+    return *result != nullptr ? 0 : ENOMEM;
+}
+
+void free(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        check("free");
+
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    check("pthread_mutex_lock");
+
+    // looked up on first use; a race only looks it up twice
+    using Lock = int (*)(pthread_mutex_t*);
+    static std::atomic<Lock> next{nullptr};
+
+    if (next.load(std::memory_order_relaxed) == nullptr)
+        next.store(reinterpret_cast<Lock>(dlsym(RTLD_NEXT, "pthread_mutex_lock")), std::memory_order_relaxed);
+
+    return next.load(std::memory_order_relaxed)(mutex);
+}
+}
+#endif